@@ -10,25 +10,570 @@
 #include <string.h>
 #include <limits.h>
 #include <time.h>
+#include <stdatomic.h>
+#include <ctype.h>
+// C11 threads are optional: macOS and C libraries before glibc 2.28 lack them, and threaded code then runs on the calling thread
+#if !defined(__STDC_NO_THREADS__) && defined(__has_include)
+#if __has_include(<threads.h>)
+#include <threads.h>
+#define ONETWOEIGHT_HAS_THREADS
+#endif // __has_include
+#endif // __STDC_NO_THREADS__
 
 #include "onetwoeight.c"
+#include "onetwoeightstats.c"
+#include "onetwoeightroutes.c"
+#include "onetwoeightexpr.c"
 
 #ifdef __SIZEOF_INT128__ // Check compiler support for native 128-bit ints
 typedef __uint128_t UInt128b;
+typedef __int128_t Int128b;
 #else
 #error "This compiler does not support 128-bit integers. Use GCC or Clang to compile this program."
 #endif // __SIZEOF_INT128__
 
+#define TEST_THREADS 4
+#define TEST_ATOMIC_ITERATIONS 100000
+#define TEST_STATS_SHARDS 3
+#define TEST_STATS_SAMPLES 100000
+#define TEST_ROUTES_RULES 1000
+#define TEST_ROUTES_SITES 6
+#define TEST_ROUTES_LOOKUPS 256
+#define TEST_EXPR_ROWS 5000 // Several blocks, the last one partial
+#define TEST_PROFILE_CALLS 1000
+
+// Carries into the high half on every other add
+static const OneTwoEight TEST_ATOMIC_STEP = (OneTwoEight){0x8000000000000001ull, 0x1ull};
+static ONETWOEIGHT_ALIGNED OneTwoEight testCounter;
+static uint64_t testSamples[TEST_STATS_SAMPLES];
+
+typedef struct TestRoute {
+    UInt128b prefix;
+    int length;
+    uint32_t nextHop;
+    bool present;
+} TestRoute;
+
+static TestRoute testRoutes[TEST_ROUTES_RULES];
+static UInt128b testSites[TEST_ROUTES_SITES];
+
+// Every formula reads column a; c is the one without null flags
+static const struct {
+    const char *text;
+    bool readsB;
+} TEST_FORMULAS[] = {
+    {"a + b * c - ~a", true},
+    {"(a - b) / c % (b | 1)", true},
+    {"a << (c & 127) ^ b >> 3 | -c", true},
+    {"a / (2 - 2)", false},
+    {"-(1 + 2) * ~0 + a", false},
+    {"(c % 7 >> 200) + (b >> a)", true},
+    {"a", false},
+    {"a & a & a & a | b & b", true}
+};
+
+static UInt128b testExprValues[3][TEST_EXPR_ROWS];
+static OneTwoEight_t testExprHalves[4][2][TEST_EXPR_ROWS]; // Columns a, b and c, then the output
+static bool testExprValid[3][TEST_EXPR_ROWS]; // Columns a and b, then the output
+
+static UInt128b test_native(const OneTwoEight NUM) {
+    return NUM.lsb | ((UInt128b)(NUM.msb) << 64);
+}
+
+static bool test_fail(const char *WHAT) {
+    printf("Error in %s!\n", WHAT);
+    return false;
+}
+
+static uint64_t test_random64(void) {
+    return rand() ^ ((uint64_t)(rand()) << 21) ^ ((uint64_t)(rand()) << 42) ^ ((uint64_t)(rand()) << 63);
+}
+
+static UInt128b test_random128(void) {
+    return test_random64() | ((UInt128b)(test_random64()) << 64);
+}
+
+static OneTwoEight test_fromNative(const UInt128b NUM) {
+    return (OneTwoEight){(OneTwoEight_t)(NUM), (OneTwoEight_t)(NUM >> 64)};
+}
+
+// Half of the increments go through fetch-and-add, the other half through a compare-exchange loop
+static int test_atomicWorker(void *unused) {
+    OneTwoEight expected;
+    int iteration;
+    
+    (void)(unused);
+    for (iteration = 0; iteration < TEST_ATOMIC_ITERATIONS; ++iteration) {
+        OneTwoEight_atomicFetchAdd(&testCounter, TEST_ATOMIC_STEP);
+        for (expected = OneTwoEight_atomicLoad(&testCounter); !OneTwoEight_atomicCompareExchange(&testCounter, &expected, OneTwoEight_add(expected, TEST_ATOMIC_STEP)););
+    }
+    return 0;
+}
+
+static bool test_atomics(void) {
+    ONETWOEIGHT_ALIGNED OneTwoEight atomic;
+    OneTwoEight expected = ONETWOEIGHT_MIN;
+    int thread;
+#ifdef ONETWOEIGHT_HAS_THREADS
+    thrd_t threads[TEST_THREADS];
+    bool started[TEST_THREADS];
+#endif // ONETWOEIGHT_HAS_THREADS
+    
+    // A failed exchange must leave memory alone and hand back what it holds
+    OneTwoEight_atomicStore(&atomic, ONETWOEIGHT_MAX);
+    if (OneTwoEight_notEqual(OneTwoEight_atomicLoad(&atomic), ONETWOEIGHT_MAX) || OneTwoEight_atomicCompareExchange(&atomic, &expected, ONETWOEIGHT_ONE)
+        || OneTwoEight_notEqual(expected, ONETWOEIGHT_MAX) || OneTwoEight_notEqual(OneTwoEight_atomicLoad(&atomic), ONETWOEIGHT_MAX)
+        || !OneTwoEight_atomicCompareExchange(&atomic, &expected, ONETWOEIGHT_ONE) || OneTwoEight_notEqual(OneTwoEight_atomicLoad(&atomic), ONETWOEIGHT_ONE)) {
+        return test_fail("atomic load, store or compare-exchange");
+    }
+    
+    // Every increment from every thread must land exactly once
+    testCounter = ONETWOEIGHT_ZERO;
+#ifdef ONETWOEIGHT_HAS_THREADS
+    for (thread = 0; thread < TEST_THREADS; ++thread) {
+        started[thread] = thrd_create(&threads[thread], test_atomicWorker, NULL) == thrd_success;
+    }
+    for (thread = 0; thread < TEST_THREADS; ++thread) {
+        if (started[thread]) {
+            thrd_join(threads[thread], NULL);
+        }
+        else {
+            test_atomicWorker(NULL);
+        }
+    }
+#else
+    for (thread = 0; thread < TEST_THREADS; ++thread) {
+        test_atomicWorker(NULL);
+    }
+#endif // ONETWOEIGHT_HAS_THREADS
+    if (test_native(testCounter) != (UInt128b)(2 * TEST_THREADS * TEST_ATOMIC_ITERATIONS) * test_native(TEST_ATOMIC_STEP)) {
+        return test_fail("contended atomic increments");
+    }
+    return true;
+}
+
+// High half of the 256-bit product, summed from 64x64-bit partial products independently of any kernel
+static UInt128b test_multiplyHigh(const UInt128b LEFT, const UInt128b RIGHT) {
+    UInt128b lowLow = (UInt128b)((uint64_t)(LEFT)) * (uint64_t)(RIGHT), lowHigh = (UInt128b)((uint64_t)(LEFT)) * (uint64_t)(RIGHT >> 64);
+    UInt128b highLow = (UInt128b)((uint64_t)(LEFT >> 64)) * (uint64_t)(RIGHT), highHigh = (UInt128b)((uint64_t)(LEFT >> 64)) * (uint64_t)(RIGHT >> 64);
+    // Bits 64 to 129 of the product: three 64-bit terms cannot overflow 128 bits
+    UInt128b middle = (lowLow >> 64) + (uint64_t)(lowHigh) + (uint64_t)(highLow);
+    
+    return highHigh + (lowHigh >> 64) + (highLow >> 64) + (middle >> 64);
+}
+
+static UInt128b test_prefixMask(const int LENGTH) {
+    return LENGTH ? (~(UInt128b)(0) << (128 - LENGTH)) : 0;
+}
+
+// An address that shares a random number of leading bits with one of a few sites, so prefixes nest inside each other
+static UInt128b test_routesAddress(void) {
+    int shared = rand() % 129;
+    
+    return testSites[rand() % TEST_ROUTES_SITES] ^ (test_random128() & ~test_prefixMask(shared));
+}
+
+// The longest present prefix containing the address, by scanning all of them
+static uint32_t test_routesScan(const UInt128b ADDRESS) {
+    uint32_t nextHop = ONETWOEIGHTROUTES_NONE;
+    int rule, longest = -1;
+    
+    for (rule = 0; rule < TEST_ROUTES_RULES; ++rule) {
+        if (testRoutes[rule].present && (testRoutes[rule].length > longest) && !((ADDRESS ^ testRoutes[rule].prefix) & test_prefixMask(testRoutes[rule].length))) {
+            longest = testRoutes[rule].length;
+            nextHop = testRoutes[rule].nextHop;
+        }
+    }
+    return nextHop;
+}
+
+static bool test_routesLookups(const OneTwoEightRoutes *ROUTES) {
+    OneTwoEight addresses[TEST_ROUTES_LOOKUPS];
+    uint32_t nextHops[TEST_ROUTES_LOOKUPS];
+    int lookup, rule;
+    
+    for (lookup = 0; lookup < TEST_ROUTES_LOOKUPS; ++lookup) {
+        // Mostly addresses inside some prefix, a few anywhere
+        rule = rand() % TEST_ROUTES_RULES;
+        addresses[lookup] = test_fromNative((lookup % 8) ? (testRoutes[rule].prefix | (test_random128() & ~test_prefixMask(testRoutes[rule].length))) : test_random128());
+    }
+    OneTwoEightRoutes_lookupBatch(ROUTES, addresses, nextHops, TEST_ROUTES_LOOKUPS);
+    for (lookup = 0; lookup < TEST_ROUTES_LOOKUPS; ++lookup) {
+        if ((OneTwoEightRoutes_lookup(ROUTES, addresses[lookup]) != nextHops[lookup]) || (nextHops[lookup] != test_routesScan(test_native(addresses[lookup])))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Inserts, replaces and withdraws prefixes at random, checking lookups against a linear scan as the table changes
+static bool test_routes(void) {
+    OneTwoEightRoutes *routes = OneTwoEightRoutes_create();
+    bool passed = true;
+    int rule, step, other;
+    
+    for (rule = 0; rule < TEST_ROUTES_SITES; ++rule) {
+        testSites[rule] = test_random128();
+    }
+    // Candidate prefixes, none repeated; they start out absent
+    for (rule = 0; rule < TEST_ROUTES_RULES; ++rule) {
+        do {
+            testRoutes[rule].length = (rule % 16) ? (16 + rand() % 113) : (rand() % 129);
+            testRoutes[rule].prefix = test_routesAddress() & test_prefixMask(testRoutes[rule].length);
+            for (other = 0; (other < rule) && ((testRoutes[other].prefix != testRoutes[rule].prefix) || (testRoutes[other].length != testRoutes[rule].length)); ++other);
+        } while (other < rule);
+        testRoutes[rule].present = false;
+    }
+    
+    for (step = 0; passed && (step < 8 * TEST_ROUTES_RULES); ++step) {
+        rule = rand() % TEST_ROUTES_RULES;
+        if (!testRoutes[rule].present || (rand() % 2)) {
+            // Host bits must be ignored, and inserting a present prefix replaces its next hop
+            testRoutes[rule].nextHop = rand() % (ONETWOEIGHTROUTES_NEXT_HOP_MAX + 1);
+            testRoutes[rule].present = true;
+            OneTwoEightRoutes_insert(routes, test_fromNative(testRoutes[rule].prefix | (test_random128() & ~test_prefixMask(testRoutes[rule].length))), testRoutes[rule].length,
+                testRoutes[rule].nextHop);
+        }
+        else {
+            // Withdrawing falls back to the next shorter prefix; a second withdrawal finds nothing
+            testRoutes[rule].present = false;
+            passed = OneTwoEightRoutes_remove(routes, test_fromNative(testRoutes[rule].prefix), testRoutes[rule].length)
+                && !OneTwoEightRoutes_remove(routes, test_fromNative(testRoutes[rule].prefix), testRoutes[rule].length);
+        }
+        if (!(step % 128)) {
+            passed = passed && test_routesLookups(routes);
+        }
+    }
+    
+    // Once everything is withdrawn nothing matches, and every group is back on the free list
+    for (rule = 0; passed && (rule < TEST_ROUTES_RULES); ++rule) {
+        passed = !testRoutes[rule].present || OneTwoEightRoutes_remove(routes, test_fromNative(testRoutes[rule].prefix), testRoutes[rule].length);
+        testRoutes[rule].present = false;
+    }
+    passed = passed && test_routesLookups(routes) && !routes->groupsInUse && !routes->ruleCount;
+    OneTwoEightRoutes_destroy(routes);
+    return passed || test_fail("longest prefix matching");
+}
+
+// Native evaluation of one row of a formula; false when the row divides by zero
+static bool test_formula(const size_t FORMULA, const UInt128b A, const UInt128b B, const UInt128b C, UInt128b *result) {
+    switch (FORMULA) {
+    case 0:
+        *result = A + B * C - ~A;
+        return true;
+    case 1:
+        *result = C ? ((A - B) / C % (B | 1)) : 0;
+        return C;
+    case 2:
+        *result = ((A << (C & 127)) ^ (B >> 3)) | -C;
+        return true;
+    case 3:
+        return false;
+    case 4:
+        *result = A + 3;
+        return true;
+    case 5:
+        // Shifts by 128 or more clear every bit
+        *result = (A < 128) ? (B >> A) : 0;
+        return true;
+    case 6:
+        *result = A;
+        return true;
+    default:
+        *result = A | B;
+        return true;
+    }
+}
+
+static bool test_exprRun(const OneTwoEightExpr *EXPR, const size_t FORMULA, const size_t ROWS, const int THREADS, const bool OUTPUT_VALID) {
+    const OneTwoEightColumn COLUMNS[3] = {
+        {testExprHalves[0][0], testExprHalves[0][1], testExprValid[0]},
+        {testExprHalves[1][0], testExprHalves[1][1], testExprValid[1]},
+        {testExprHalves[2][0], testExprHalves[2][1], NULL}
+    };
+    const OneTwoEightColumn OUTPUT = {testExprHalves[3][0], testExprHalves[3][1], OUTPUT_VALID ? testExprValid[2] : NULL};
+    UInt128b expected = 0;
+    bool valid;
+    size_t row;
+    
+    // Rows past the end must be left alone
+    memset(testExprHalves[3], 0xa5, sizeof(testExprHalves[3]));
+    OneTwoEightExpr_evaluate(EXPR, COLUMNS, &OUTPUT, ROWS, THREADS);
+    for (row = 0; row < ROWS; ++row) {
+        valid = testExprValid[0][row] && (!TEST_FORMULAS[FORMULA].readsB || testExprValid[1][row])
+            && test_formula(FORMULA, testExprValues[0][row], testExprValues[1][row], testExprValues[2][row], &expected);
+        // Null rows come out as zero
+        if (((valid ? expected : 0) != (testExprHalves[3][0][row] | ((UInt128b)(testExprHalves[3][1][row]) << 64))) || (OUTPUT_VALID && (testExprValid[2][row] != valid))) {
+            return false;
+        }
+    }
+    return (ROWS == TEST_EXPR_ROWS) || (testExprHalves[3][0][ROWS] == 0xa5a5a5a5a5a5a5a5ull);
+}
+
+// Formulas over columns with null rows and zero divisors, against native arithmetic row by row
+static bool test_expr(void) {
+    static const char *const NAMES[] = {"a", "b", "c"}, *const MALFORMED[] = {"-", "(a", "a b", "340282366920938463463374607431768211456", ""};
+    OneTwoEightExpr *expr;
+    size_t row, column, formula;
+    bool passed = true;
+    
+    for (row = 0; row < TEST_EXPR_ROWS; ++row) {
+        for (column = 0; column < 3; ++column) {
+            // Mostly full width, then small values that make sensible shift amounts, ones only the high half keeps from being small, and zeros
+            switch (rand() % 8) {
+            case 0:
+                testExprValues[column][row] = 0;
+                break;
+            case 1:
+                testExprValues[column][row] = ((UInt128b)(1) << 64) | (rand() % 200);
+                break;
+            case 2:
+            case 3:
+                testExprValues[column][row] = rand() % 200;
+                break;
+            default:
+                testExprValues[column][row] = test_random128();
+            }
+            testExprHalves[column][0][row] = (OneTwoEight_t)(testExprValues[column][row]);
+            testExprHalves[column][1][row] = (OneTwoEight_t)(testExprValues[column][row] >> 64);
+        }
+        testExprValid[0][row] = rand() % 16;
+        testExprValid[1][row] = rand() % 16;
+    }
+    
+    for (formula = 0; passed && (formula < sizeof(TEST_FORMULAS) / sizeof(TEST_FORMULAS[0])); ++formula) {
+        if (!(expr = OneTwoEightExpr_compile(TEST_FORMULAS[formula].text, NAMES, 3))) {
+            return test_fail("compiling a formula");
+        }
+        // One thread, several threads with and without output flags, and more threads than blocks
+        passed = test_exprRun(expr, formula, TEST_EXPR_ROWS, 1, true) && test_exprRun(expr, formula, TEST_EXPR_ROWS, TEST_THREADS, true)
+            && test_exprRun(expr, formula, TEST_EXPR_ROWS, 3, false) && test_exprRun(expr, formula, ONETWOEIGHTEXPR_BLOCK + 1, TEST_THREADS, true);
+        OneTwoEightExpr_destroy(expr);
+    }
+    if (!passed) {
+        return test_fail("formula evaluation");
+    }
+    
+    // Each of these is reported on stderr and rejected
+    for (formula = 0; formula < sizeof(MALFORMED) / sizeof(MALFORMED[0]); ++formula) {
+        if ((expr = OneTwoEightExpr_compile(MALFORMED[formula], NAMES, 3))) {
+            OneTwoEightExpr_destroy(expr);
+            return test_fail("rejecting a malformed formula");
+        }
+    }
+    return true;
+}
+
+// Operands random ones almost never hit: the overflowing minimum, and shift amounts outside 0 to 127
+static bool test_signedEdges(void) {
+    static const int SHIFTS[] = {128, 129, 200, INT_MAX, -1, -64, INT_MIN};
+    const OneTwoEight MINUS_ONE = ONETWOEIGHT_UMAX;
+    OneTwoEight rem = ONETWOEIGHT_ONE;
+    size_t shift;
+    
+    // Native code cannot compute these without undefined behavior, so the documented results are spelled out
+    if (OneTwoEight_notEqual(OneTwoEight_sdivide(ONETWOEIGHT_MIN, MINUS_ONE, true, &rem), ONETWOEIGHT_MIN) || OneTwoEight_toBool(rem)
+        || OneTwoEight_toBool(OneTwoEight_smodulus(ONETWOEIGHT_MIN, MINUS_ONE)) || OneTwoEight_notEqual(OneTwoEight_abs(ONETWOEIGHT_MIN), ONETWOEIGHT_MIN)
+        || OneTwoEight_notEqual(OneTwoEight_negate(ONETWOEIGHT_MIN), ONETWOEIGHT_MIN)) {
+        return test_fail("signed operations on ONETWOEIGHT_MIN");
+    }
+    // Those that are defined still go through the native type
+    if ((test_native(OneTwoEight_sdivide(ONETWOEIGHT_MIN, ONETWOEIGHT_MAX, false, NULL)) != (UInt128b)((Int128b)(test_native(ONETWOEIGHT_MIN)) / (Int128b)(test_native(ONETWOEIGHT_MAX))))
+        || (test_native(OneTwoEight_smodulus(ONETWOEIGHT_MIN, ONETWOEIGHT_MAX)) != (UInt128b)((Int128b)(test_native(ONETWOEIGHT_MIN)) % (Int128b)(test_native(ONETWOEIGHT_MAX))))
+        || OneTwoEight_notEqual(OneTwoEight_sdivide(ONETWOEIGHT_MIN, ONETWOEIGHT_MIN, false, NULL), ONETWOEIGHT_ONE)
+        || OneTwoEight_notEqual(OneTwoEight_sdivide(ONETWOEIGHT_MAX, MINUS_ONE, false, NULL), OneTwoEight_negate(ONETWOEIGHT_MAX))) {
+        return test_fail("signed division of the limits");
+    }
+    // Shifting by 128 or more, or by a negative amount, leaves only copies of the sign bit
+    for (shift = 0; shift < sizeof(SHIFTS) / sizeof(SHIFTS[0]); ++shift) {
+        if (OneTwoEight_notEqual(OneTwoEight_arithmeticRightShift(ONETWOEIGHT_MIN, SHIFTS[shift]), MINUS_ONE)
+            || OneTwoEight_notEqual(OneTwoEight_arithmeticRightShift(MINUS_ONE, SHIFTS[shift]), MINUS_ONE)
+            || OneTwoEight_toBool(OneTwoEight_arithmeticRightShift(ONETWOEIGHT_MAX, SHIFTS[shift]))) {
+            return test_fail("arithmetic right shift out of range");
+        }
+    }
+    return true;
+}
+
+// Checks a summary of the first COUNT samples against native arithmetic
+static bool test_statsSummary(const OneTwoEightStatsSummary SUMMARY, const size_t COUNT) {
+    UInt128b sum = 0, sumSquares = 0, deviations = 0, count = COUNT, mean, rem, deviation;
+    uint64_t min = UINT64_MAX, max = 0;
+    OneTwoEight meanRem;
+    size_t sample;
+    
+    for (sample = 0; sample < COUNT; ++sample) {
+        sum += testSamples[sample];
+        sumSquares += (UInt128b)(testSamples[sample]) * testSamples[sample];
+        min = (testSamples[sample] < min) ? testSamples[sample] : min;
+        max = (testSamples[sample] > max) ? testSamples[sample] : max;
+    }
+    mean = COUNT ? (sum / count) : 0;
+    rem = COUNT ? (sum % count) : 0;
+    // Distances from the floored mean, squared; the samples are picked so that count * deviations stays within 128 bits
+    for (sample = 0; sample < COUNT; ++sample) {
+        deviation = (testSamples[sample] > mean) ? (testSamples[sample] - mean) : (mean - testSamples[sample]);
+        deviations += deviation * deviation;
+    }
+    // count * variance = deviations - rem * rem / count
+    return (test_native(SUMMARY.sum) == sum) && (test_native(SUMMARY.sumSquares) == sumSquares) && (SUMMARY.count == COUNT) && (SUMMARY.min == min) && (SUMMARY.max == max)
+        && (test_native(OneTwoEightStats_mean(SUMMARY, &meanRem)) == mean) && (test_native(meanRem) == rem)
+        && (test_native(OneTwoEightStats_variance(SUMMARY)) == (COUNT ? ((count * deviations - rem * rem) / (count * count)) : 0));
+}
+
+// Records the first COUNT samples round robin across the shards
+static bool test_statsRun(const size_t COUNT) {
+    OneTwoEightStats *stats = OneTwoEightStats_create(TEST_STATS_SHARDS);
+    OneTwoEightStatsShard *shards[TEST_STATS_SHARDS];
+    bool passed = true;
+    size_t sample;
+    int shard;
+    
+    for (shard = 0; shard < TEST_STATS_SHARDS; ++shard) {
+        passed = passed && (shards[shard] = OneTwoEightStats_acquireShard(stats));
+    }
+    // Extra writers are turned away however often they ask
+    for (shard = 0; shard < 1000; ++shard) {
+        passed = passed && !OneTwoEightStats_acquireShard(stats);
+    }
+    if (!passed || (atomic_load(&stats->shardsTaken) != TEST_STATS_SHARDS)) {
+        OneTwoEightStats_destroy(stats);
+        return false;
+    }
+    for (sample = 0; sample < COUNT; ++sample) {
+        OneTwoEightStats_record(shards[sample % TEST_STATS_SHARDS], testSamples[sample]);
+    }
+    // Nothing is published until the first epoch boundary
+    passed = test_statsSummary(OneTwoEightStats_published(stats), 0) && test_statsSummary(OneTwoEightStats_merge(stats), COUNT);
+    OneTwoEightStats_publish(stats);
+    passed = passed && test_statsSummary(OneTwoEightStats_published(stats), COUNT);
+    OneTwoEightStats_destroy(stats);
+    return passed;
+}
+
+static bool test_stats(void) {
+    static const uint64_t SMALL[] = {1, 2, 3, 4}, WIDE[] = {0, UINT64_MAX};
+    bool passed = test_statsRun(0);
+    size_t sample;
+    
+    memcpy(testSamples, SMALL, sizeof(SMALL));
+    passed = passed && test_statsRun(sizeof(SMALL) / sizeof(SMALL[0]));
+    // The widest spread there is: the variance is 2^126 - 2^63, rounded down from a quarter above it
+    memcpy(testSamples, WIDE, sizeof(WIDE));
+    passed = passed && test_statsRun(sizeof(WIDE) / sizeof(WIDE[0]));
+    // A few samples around 2^62, whose squares come close to filling 128 bits
+    for (sample = 0; sample < 8; ++sample) {
+        testSamples[sample] = (1ull << 62) + (test_random64() >> 14);
+    }
+    passed = passed && test_statsRun(8);
+    // Many samples spread over 32 bits, so the mean almost surely has a remainder
+    for (sample = 0; sample < TEST_STATS_SAMPLES; ++sample) {
+        testSamples[sample] = test_random64() >> 32;
+    }
+    passed = passed && test_statsRun(TEST_STATS_SAMPLES);
+    return passed || test_fail("statistics");
+}
+
+#ifdef ONETWOEIGHT_PROFILE
+// Adds that a thread makes and then exits, so its counters have to be retired for the merge to see them
+static int test_profileWorker(void *unused) {
+    OneTwoEight sum = ONETWOEIGHT_ZERO;
+    int call;
+    
+    (void)(unused);
+    for (call = 0; call < TEST_PROFILE_CALLS; ++call) {
+        sum = OneTwoEight_add(sum, ONETWOEIGHT_ONE);
+    }
+    return OneTwoEight_toInt(sum) != TEST_PROFILE_CALLS;
+}
+
+static bool test_profile(void) {
+    // The generic kernel takes its slow path on a dividend with the top bit set, mul and bmi2 on a divisor wider than 64 bits
+    const OneTwoEight TOP_DIVIDEND = {0x123456789ull, 0x8000000000000000ull}, WIDE_DIVISOR = {0x1ull, 0x1ull}, MINUS_SEVEN = {-7ull, -1ull};
+    OneTwoEightProfile before = OneTwoEight_profileMerge(), after;
+    uint64_t expected[ONETWOEIGHT_PROFILE_OPERATOR_COUNT] = {0}, adds = TEST_PROFILE_CALLS;
+    char header[128] = "";
+    FILE *dump;
+    int call, which;
+#ifdef ONETWOEIGHT_HAS_THREADS
+    thrd_t thread;
+#endif // ONETWOEIGHT_HAS_THREADS
+    
+    // Each of these calls other operators inside; only the outer call may count
+    for (call = 0; call < TEST_PROFILE_CALLS; ++call) {
+        OneTwoEight_divide(TOP_DIVIDEND, OneTwoEight_fromInt(call + 3), false, NULL);
+        OneTwoEight_divide(OneTwoEight_fromInt(call), WIDE_DIVISOR, false, NULL);
+        OneTwoEight_sdivide(OneTwoEight_fromInt(call), MINUS_SEVEN, false, NULL);
+    }
+#ifdef ONETWOEIGHT_HAS_THREADS
+    if (thrd_create(&thread, test_profileWorker, NULL) == thrd_success) {
+        thrd_join(thread, NULL);
+        adds += TEST_PROFILE_CALLS;
+    }
+#endif // ONETWOEIGHT_HAS_THREADS
+    test_profileWorker(NULL);
+    after = OneTwoEight_profileMerge();
+    
+    expected[ONETWOEIGHT_PROFILE_divide] = 2 * TEST_PROFILE_CALLS;
+    expected[ONETWOEIGHT_PROFILE_sdivide] = TEST_PROFILE_CALLS;
+    expected[ONETWOEIGHT_PROFILE_add] = adds;
+    for (which = 0; which < ONETWOEIGHT_PROFILE_OPERATOR_COUNT; ++which) {
+        if (after.calls[which] - before.calls[which] != expected[which]) {
+            return test_fail("profile call counts");
+        }
+#ifdef ONETWOEIGHT_PROFILE_CYCLES
+        if (!expected[which] != (after.cycles[which] == before.cycles[which])) {
+#else
+        if (after.cycles[which]) {
+#endif // ONETWOEIGHT_PROFILE_CYCLES
+            return test_fail("profile cycle counts");
+        }
+    }
+    if (after.divideSlowPaths - before.divideSlowPaths != TEST_PROFILE_CALLS) {
+        return test_fail("profile division slow paths");
+    }
+    
+    // The cycle columns only appear when there are cycles to show
+    if (!(dump = tmpfile())) {
+        return true;
+    }
+    OneTwoEight_profileDump(dump);
+    rewind(dump);
+    if (!fgets(header, sizeof(header), dump)) {
+        header[0] = '\0';
+    }
+    fclose(dump);
+#ifdef ONETWOEIGHT_PROFILE_CYCLES
+    if (strncmp(header, "Operator", 8) || !strstr(header, "Cycles/call")) {
+#else
+    if (strncmp(header, "Operator", 8) || strstr(header, "Cycles")) {
+#endif // ONETWOEIGHT_PROFILE_CYCLES
+        return test_fail("profile dump");
+    }
+    return true;
+}
+#endif // ONETWOEIGHT_PROFILE
+
 // Driver code to debug C operators on the OneTwoEight type
 int main(void) {
-    OneTwoEight a, b, c;
-    UInt128b _a, _b, _c;
-    unsigned long long operation, shift, _d, _e, _f[39];
+    ONETWOEIGHT_ALIGNED OneTwoEight a, b, c;
+    UInt128b _a, _b, _c, _d;
+    unsigned long long operation, shift, _e, _f[39];
     bool cond, _cond;
     
     // Initialize the PRNG
     srand(time(NULL));
     
+    // Fixed checks first, then random operands forever
+    if (!test_atomics() || !test_stats() || !test_routes() || !test_signedEdges() || !test_expr()) {
+        return 1;
+    }
+#ifdef ONETWOEIGHT_PROFILE
+    if (!test_profile()) {
+        return 1;
+    }
+#endif // ONETWOEIGHT_PROFILE
+    
     for (;;) {
         // Fill with random numbers
         a.lsb = rand() | (((OneTwoEight_t)(rand()) & 1) << 31) | ((OneTwoEight_t)(rand()) << 32) | (((OneTwoEight_t)(rand()) & 1) << 63);
@@ -43,7 +588,7 @@ int main(void) {
         cond = _cond = false;
         
         // Randomize operations
-        operation = rand() % 34;
+        operation = rand() % 50;
         shift = rand() % 128;
         
         // Do this operation based on RNG result
@@ -195,6 +740,77 @@ int main(void) {
         case 33: // Greater than or equal
             cond = OneTwoEight_greaterThanEqual(a, b);
             _cond = _a >= _b;
+            break;
+        case 34: // Atomic fetch and add
+            OneTwoEight_atomicFetchAdd(&c, a);
+            _c += _a;
+            break;
+        case 35: // Atomic fetch and OR
+            OneTwoEight_atomicFetchOr(&c, a);
+            _c |= _a;
+            break;
+        case 36: // Full-width multiply, high half
+            OneTwoEight_multiplyFull(a, b, &c);
+            _c = test_multiplyHigh(_a, _b);
+            break;
+        case 37: // Signed divide
+            if (OneTwoEight_toBool(b) && _b && !((_a == ((UInt128b)(1) << 127)) && (_b == ~(UInt128b)(0)))) { // Also avoid overflowing the minimum
+                c = OneTwoEight_sdivide(a, b, false, NULL);
+                _c = (Int128b)(_a) / (Int128b)(_b);
+                break;
+            }
+            continue;
+        case 38: // Signed modulus
+            if (OneTwoEight_toBool(b) && _b && !((_a == ((UInt128b)(1) << 127)) && (_b == ~(UInt128b)(0)))) {
+                c = OneTwoEight_smodulus(a, b);
+                _c = (Int128b)(_a) % (Int128b)(_b);
+                break;
+            }
+            continue;
+        case 39: // Arithmetic right shift
+            c = OneTwoEight_arithmeticRightShift(a, shift);
+            _c = (Int128b)(_a) >> shift;
+            break;
+        // Signed relational results go through c, so they are checked even when both conditions are true
+        case 40: // Signed less than
+            c = OneTwoEight_fromBool(OneTwoEight_slessThan(a, b));
+            _c = (Int128b)(_a) < (Int128b)(_b);
+            break;
+        case 41: // Signed less than or equal
+            c = OneTwoEight_fromBool(OneTwoEight_slessThanEqual(a, b));
+            _c = (Int128b)(_a) <= (Int128b)(_b);
+            break;
+        case 42: // Signed greater than
+            c = OneTwoEight_fromBool(OneTwoEight_sgreaterThan(a, b));
+            _c = (Int128b)(_a) > (Int128b)(_b);
+            break;
+        case 43: // Signed greater than or equal
+            c = OneTwoEight_fromBool(OneTwoEight_sgreaterThanEqual(a, b));
+            _c = (Int128b)(_a) >= (Int128b)(_b);
+            break;
+        case 44: // Negate
+            c = OneTwoEight_negate(a);
+            _c = -_a;
+            break;
+        case 45: // Absolute value
+            c = OneTwoEight_abs(a);
+            _c = ((Int128b)(_a) < 0) ? -_a : _a;
+            break;
+        case 46: // Signed minimum
+            c = OneTwoEight_smin(a, b);
+            _c = ((Int128b)(_a) < (Int128b)(_b)) ? _a : _b;
+            break;
+        case 47: // Signed maximum
+            c = OneTwoEight_smax(a, b);
+            _c = ((Int128b)(_a) > (Int128b)(_b)) ? _a : _b;
+            break;
+        case 48: // Sign, offset by one to stay non-negative
+            c = OneTwoEight_fromInt(OneTwoEight_sign(a) + 1);
+            _c = ((Int128b)(_a) > 0) - ((Int128b)(_a) < 0) + 1;
+            break;
+        case 49: // Full-width multiply, low half
+            c = OneTwoEight_multiplyFull(a, b, NULL);
+            _c = _a * _b;
         }
         
         // Verify the results and error out if answers are different from what is expected.
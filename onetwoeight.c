@@ -4,7 +4,155 @@
 
 #include "onetwoeight.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#ifndef ONETWOEIGHT_ATOMIC_LOCKS
+#define ONETWOEIGHT_HAS_CMPXCHG16B
+#endif // ONETWOEIGHT_ATOMIC_LOCKS
+#define ONETWOEIGHT_HAS_X86_64_KERNELS
+#endif // __x86_64__
+
+// Number of spinlocks the atomic fallback hashes addresses onto; each one sits on its own cache line
+#define ONETWOEIGHT_ATOMIC_STRIPES 64
+
+static struct {
+    _Alignas(64) atomic_bool locked;
+} OneTwoEight_atomicStripes[ONETWOEIGHT_ATOMIC_STRIPES];
+
+#ifdef ONETWOEIGHT_PROFILE
+#if !(defined(__GNUC__) || defined(__clang__))
+#error "ONETWOEIGHT_PROFILE needs the cleanup attribute from GCC or Clang."
+#endif
+#ifdef ONETWOEIGHT_PROFILE_CYCLES
+#if !(defined(__x86_64__) || defined(__i386__))
+#error "ONETWOEIGHT_PROFILE_CYCLES needs rdtsc on x86."
+#endif
+#include <x86intrin.h>
+#endif // ONETWOEIGHT_PROFILE_CYCLES
+
+// Counters of one thread; with C11 threads an exiting thread retires them, otherwise they are never freed
+typedef struct OneTwoEightProfileThread {
+    atomic_uint_least64_t calls[ONETWOEIGHT_PROFILE_OPERATOR_COUNT], cycles[ONETWOEIGHT_PROFILE_OPERATOR_COUNT], divideSlowPaths;
+    struct OneTwoEightProfileThread *next;
+} OneTwoEightProfileThread;
+
+// Registering, retiring and merging are rare, so one spinlock guards the list of live threads and the totals of exited ones
+static atomic_flag OneTwoEight_profileLock = ATOMIC_FLAG_INIT;
+static OneTwoEightProfileThread *OneTwoEight_profileThreads;
+static OneTwoEightProfile OneTwoEight_profileRetired;
+static _Thread_local OneTwoEightProfileThread *OneTwoEight_profileThread;
+static _Thread_local int OneTwoEight_profileDepth; // Operators entered and not yet left on this thread
+#ifdef ONETWOEIGHT_HAS_THREADS
+static tss_t OneTwoEight_profileExit; // Only there to run OneTwoEight_profileRetire when a thread exits
+static once_flag OneTwoEight_profileExitOnce = ONCE_FLAG_INIT;
+#endif // ONETWOEIGHT_HAS_THREADS
+
+static void OneTwoEight_profileAcquire(void) {
+    while (atomic_flag_test_and_set_explicit(&OneTwoEight_profileLock, memory_order_acquire));
+}
+
+static void OneTwoEight_profileRelease(void) {
+    atomic_flag_clear_explicit(&OneTwoEight_profileLock, memory_order_release);
+}
+
+static void OneTwoEight_profileAdd(OneTwoEightProfile *total, OneTwoEightProfileThread *thread) {
+    int which;
+    
+    for (which = 0; which < ONETWOEIGHT_PROFILE_OPERATOR_COUNT; ++which) {
+        total->calls[which] += atomic_load_explicit(&thread->calls[which], memory_order_relaxed);
+        total->cycles[which] += atomic_load_explicit(&thread->cycles[which], memory_order_relaxed);
+    }
+    total->divideSlowPaths += atomic_load_explicit(&thread->divideSlowPaths, memory_order_relaxed);
+}
+
+#ifdef ONETWOEIGHT_HAS_THREADS
+static void OneTwoEight_profileRetire(void *thread) {
+    OneTwoEightProfileThread **link;
+    
+    OneTwoEight_profileAcquire();
+    OneTwoEight_profileAdd(&OneTwoEight_profileRetired, thread);
+    for (link = &OneTwoEight_profileThreads; *link != thread; link = &(*link)->next);
+    *link = (*link)->next;
+    OneTwoEight_profileRelease();
+    free(thread);
+    // A later destructor that still calls an operator registers this thread again
+    OneTwoEight_profileThread = NULL;
+}
+
+static void OneTwoEight_profileRetireInit(void) {
+    if (tss_create(&OneTwoEight_profileExit, OneTwoEight_profileRetire) != thrd_success) {
+        fprintf(stderr, "Out of thread-specific storage.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+#endif // ONETWOEIGHT_HAS_THREADS
+
+static OneTwoEightProfileThread *OneTwoEight_profileLocal(void) {
+    OneTwoEightProfileThread *local = OneTwoEight_profileThread;
+    
+    // Register this thread on its first operator call
+    if (!local) {
+        if (!(local = calloc(1, sizeof(OneTwoEightProfileThread)))) {
+            fprintf(stderr, "Out of memory.\n");
+            exit(EXIT_FAILURE);
+        }
+#ifdef ONETWOEIGHT_HAS_THREADS
+        call_once(&OneTwoEight_profileExitOnce, OneTwoEight_profileRetireInit);
+        tss_set(OneTwoEight_profileExit, local);
+#endif // ONETWOEIGHT_HAS_THREADS
+        OneTwoEight_profileAcquire();
+        local->next = OneTwoEight_profileThreads;
+        OneTwoEight_profileThreads = local;
+        OneTwoEight_profileRelease();
+        OneTwoEight_profileThread = local;
+    }
+    return local;
+}
+
+static void OneTwoEight_profileBump(atomic_uint_least64_t *counter, const uint64_t AMOUNT) {
+    // Only the owning thread writes its counters, so a relaxed load and store stand in for a locked add
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + AMOUNT, memory_order_relaxed);
+}
+
+typedef struct OneTwoEightProfileScope {
+    OneTwoEightProfileOperator which;
+    uint64_t start;
+} OneTwoEightProfileScope;
+
+static inline OneTwoEightProfileScope OneTwoEight_profileEnter(const OneTwoEightProfileOperator WHICH) {
+    // Operators the library calls on its own behalf are part of the outermost call's work, so only that one is counted
+    if (OneTwoEight_profileDepth++) {
+        return (OneTwoEightProfileScope){WHICH, 0};
+    }
+    OneTwoEight_profileBump(&OneTwoEight_profileLocal()->calls[WHICH], 1);
+#ifdef ONETWOEIGHT_PROFILE_CYCLES
+    return (OneTwoEightProfileScope){WHICH, __rdtsc()};
+#else
+    return (OneTwoEightProfileScope){WHICH, 0};
+#endif // ONETWOEIGHT_PROFILE_CYCLES
+}
+
+static inline void OneTwoEight_profileLeave(OneTwoEightProfileScope *scope) {
+    if (--OneTwoEight_profileDepth) {
+        return;
+    }
+#ifdef ONETWOEIGHT_PROFILE_CYCLES
+    OneTwoEight_profileBump(&OneTwoEight_profileLocal()->cycles[scope->which], __rdtsc() - scope->start);
+#else
+    (void)(scope);
+#endif // ONETWOEIGHT_PROFILE_CYCLES
+}
+
+// The cleanup attribute leaves the scope on whichever return the operator takes
+#define ONETWOEIGHT_PROFILE_CALL(NAME) OneTwoEightProfileScope oneTwoEightProfileScope __attribute__((cleanup(OneTwoEight_profileLeave))) = OneTwoEight_profileEnter(ONETWOEIGHT_PROFILE_##NAME)
+#define ONETWOEIGHT_PROFILE_SLOW_PATH() OneTwoEight_profileBump(&OneTwoEight_profileLocal()->divideSlowPaths, 1)
+#else
+#define ONETWOEIGHT_PROFILE_CALL(NAME)
+#define ONETWOEIGHT_PROFILE_SLOW_PATH()
+#endif // ONETWOEIGHT_PROFILE
+
 OneTwoEight OneTwoEight_add(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(add);
     OneTwoEight_t sumLSB, sumMSB;
     
     // Add
@@ -16,6 +164,7 @@ OneTwoEight OneTwoEight_add(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
 }
 
 OneTwoEight OneTwoEight_subtract(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(subtract);
     OneTwoEight_t diffLSB, diffMSB;
     
     // Subtract
@@ -26,49 +175,90 @@ OneTwoEight OneTwoEight_subtract(const OneTwoEight LEFT, const OneTwoEight RIGHT
     return (OneTwoEight){diffLSB, diffMSB};
 }
 
-OneTwoEight OneTwoEight_multiply(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
-    OneTwoEight_t leftLSBL, leftLSBM, rightLSBL, rightLSBM;
+/*
+    Multiplication and division kernels, picked once at startup from what the processor supports
+    generic: portable C built from 32-bit partial products and shift-subtract division
+    mul: x86-64 mul and div instructions
+    bmi2: mulx with the two independent adcx/adox carry chains; division is the same as mul, since BMI2 and ADX do nothing for div
+    Set the ONETWOEIGHT_KERNEL environment variable to one of these names to force it, e.g. when benchmarking
+*/
+typedef struct OneTwoEightKernels {
+    const char *name;
+    bool (*supported)(void);
+    OneTwoEight (*multiply)(const OneTwoEight, const OneTwoEight);
+    OneTwoEight (*multiplyFull)(const OneTwoEight, const OneTwoEight, OneTwoEight*);
+    OneTwoEight (*divide)(OneTwoEight, OneTwoEight, OneTwoEight*); // Divisor is nonzero; always stores the remainder
+} OneTwoEightKernels;
+
+static bool OneTwoEight_kernelAlwaysSupported(void) {
+    return true;
+}
+
+static OneTwoEight OneTwoEight_multiply64Generic(const OneTwoEight_t LEFT, const OneTwoEight_t RIGHT) {
+    OneTwoEight_t leftL, leftM, rightL, rightM;
     OneTwoEight_t firstProd, secondProd, thirdProd, fourthProd;
     OneTwoEight_t firstPart, secondPart;
-    OneTwoEight_t least64ProdBits, most64ProdBits;
     
     // The result of multiplication of N bit integers is in 2N bits
     // 64x64 = 128-bit product
-    // 128x128 = 256-bit product
-    // Break apart 64-bit LSB integers into padded 32-bit integers
-    leftLSBL = LEFT.lsb & UINT32_MAX;
-    leftLSBM = LEFT.lsb >> 32;
-    rightLSBL = RIGHT.lsb & UINT32_MAX;
-    rightLSBM = RIGHT.lsb >> 32;
+    // Break apart 64-bit integers into padded 32-bit integers
+    leftL = LEFT & UINT32_MAX;
+    leftM = LEFT >> 32;
+    rightL = RIGHT & UINT32_MAX;
+    rightM = RIGHT >> 32;
     
     // Multiply partial products
-    firstProd = leftLSBL * rightLSBL;
-    secondProd = leftLSBL * rightLSBM;
-    thirdProd = leftLSBM * rightLSBL;
-    fourthProd = leftLSBM * rightLSBM;
+    firstProd = leftL * rightL;
+    secondProd = leftL * rightM;
+    thirdProd = leftM * rightL;
+    fourthProd = leftM * rightM;
     
     // Get lower and higher 32-bit parts of 64-bit products and add them, taking into account carries and overflows
     firstPart = (firstProd >> 32) + thirdProd;
     secondPart = (firstPart & UINT32_MAX) + secondProd;
     
-    // Combine them together; we now have a truncated 128-bit product
-    least64ProdBits = (firstProd & UINT32_MAX) + (secondPart << 32);
-    most64ProdBits = (fourthProd + (firstPart >> 32) + (secondPart >> 32)) + (LEFT.lsb * RIGHT.msb) + (LEFT.msb * RIGHT.lsb);
+    // Combine them together
+    return (OneTwoEight){(firstProd & UINT32_MAX) + (secondPart << 32), fourthProd + (firstPart >> 32) + (secondPart >> 32)};
+}
+
+static inline OneTwoEight OneTwoEight_multiplyWith(const OneTwoEight LEFT, const OneTwoEight RIGHT, OneTwoEight (*MULTIPLY64)(const OneTwoEight_t, const OneTwoEight_t)) {
+    // 128x128 = 256-bit product, truncated to 128 bits: only the low halves need a full 64x64-bit product
+    // The cross products land entirely in the upper half, so their own upper halves fall off the end
+    OneTwoEight product = MULTIPLY64(LEFT.lsb, RIGHT.lsb);
     
-    // Return that product
-    return (OneTwoEight){least64ProdBits, most64ProdBits};
+    product.msb += (LEFT.lsb * RIGHT.msb) + (LEFT.msb * RIGHT.lsb);
+    return product;
 }
 
-OneTwoEight OneTwoEight_divide(OneTwoEight LEFT, OneTwoEight RIGHT, const bool USE_REM, OneTwoEight *REM_128) {
-    // Division is usually the slowest basic operation of any integer type
-    OneTwoEight quot, rem, left;
-    OneTwoEight_t bitsLeft, leftMSBit;
+static inline OneTwoEight OneTwoEight_multiplyFullWith(const OneTwoEight LEFT, const OneTwoEight RIGHT, OneTwoEight *HIGH, OneTwoEight (*MULTIPLY64)(const OneTwoEight_t, const OneTwoEight_t)) {
+    OneTwoEight lowProd, leftCrossProd, rightCrossProd, highProd, middle;
     
-    // Check for zero divisor, a classic undefined mathematical operation
-    if (!OneTwoEight_toBool(RIGHT)) {
-        fprintf(stderr, "Division by zero.\n");
-        exit(EXIT_FAILURE);
+    // Schoolbook multiplication on 64-bit digits
+    lowProd = MULTIPLY64(LEFT.lsb, RIGHT.lsb);
+    leftCrossProd = MULTIPLY64(LEFT.lsb, RIGHT.msb);
+    rightCrossProd = MULTIPLY64(LEFT.msb, RIGHT.lsb);
+    highProd = MULTIPLY64(LEFT.msb, RIGHT.msb);
+    
+    // A 64x64-bit product is at most 2^128 - 2^65 + 1, so adding one 64-bit digit to it cannot overflow, but adding another product can
+    middle = OneTwoEight_add(leftCrossProd, OneTwoEight_fromUInt64(lowProd.msb));
+    OneTwoEight_addAssign(&middle, rightCrossProd);
+    if (HIGH) {
+        *HIGH = OneTwoEight_add(highProd, (OneTwoEight){middle.msb, OneTwoEight_lessThan(middle, rightCrossProd)});
     }
+    return (OneTwoEight){lowProd.lsb, middle.lsb};
+}
+
+static OneTwoEight OneTwoEight_multiplyGeneric(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    return OneTwoEight_multiplyWith(LEFT, RIGHT, OneTwoEight_multiply64Generic);
+}
+
+static OneTwoEight OneTwoEight_multiplyFullGeneric(const OneTwoEight LEFT, const OneTwoEight RIGHT, OneTwoEight *HIGH) {
+    return OneTwoEight_multiplyFullWith(LEFT, RIGHT, HIGH, OneTwoEight_multiply64Generic);
+}
+
+static OneTwoEight OneTwoEight_divideGeneric(OneTwoEight LEFT, OneTwoEight RIGHT, OneTwoEight *REM_128) {
+    OneTwoEight quot, rem, left;
+    OneTwoEight_t bitsLeft, leftMSBit;
     
     // Prepare quotient and remainder for division
     quot = rem = ONETWOEIGHT_ZERO;
@@ -77,6 +267,7 @@ OneTwoEight OneTwoEight_divide(OneTwoEight LEFT, OneTwoEight RIGHT, const bool U
     // See if the dividend's MSB is on, and use the slower binary long division algorithm
     // It is correct for every value of any n-bit integer, unlike the faster one inside the else block
     if (leftMSBit) {
+        ONETWOEIGHT_PROFILE_SLOW_PATH();
         // Perform this algorithm based on Wikipedia's article on division algorithms
         // It is adapted to work with this data structure, see https://en.wikipedia.org/wiki/Division_algorithm#Long_division
         // Grab number of bits in dividend
@@ -118,52 +309,234 @@ OneTwoEight OneTwoEight_divide(OneTwoEight LEFT, OneTwoEight RIGHT, const bool U
         }
     }
     
+    // The slow algorithm accumulates the remainder separately; the fast one leaves it in the dividend
+    *REM_128 = leftMSBit ? rem : LEFT;
+    return quot;
+}
+
+static const OneTwoEightKernels ONETWOEIGHT_KERNELS_GENERIC = {"generic", OneTwoEight_kernelAlwaysSupported, OneTwoEight_multiplyGeneric, OneTwoEight_multiplyFullGeneric, OneTwoEight_divideGeneric};
+
+#ifdef ONETWOEIGHT_HAS_X86_64_KERNELS
+static bool OneTwoEight_kernelBMI2Supported(void) {
+    unsigned eax, ebx, ecx, edx;
+    
+    // Structured extended feature flags live in leaf 7, subleaf 0
+    return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_BMI2) && (ebx & bit_ADX);
+}
+
+static OneTwoEight OneTwoEight_multiply64Mul(const OneTwoEight_t LEFT, const OneTwoEight_t RIGHT) {
+    OneTwoEight product;
+    
+    // One instruction produces the whole 128-bit product in RDX:RAX
+    __asm__("mulq %3" : "=a"(product.lsb), "=d"(product.msb) : "%a"(LEFT), "rm"(RIGHT) : "cc");
+    return product;
+}
+
+static OneTwoEight_t OneTwoEight_divide64Mul(const OneTwoEight_t HIGH, const OneTwoEight_t LOW, const OneTwoEight_t DIVISOR, OneTwoEight_t *rem) {
+    OneTwoEight_t quot;
+    
+    // Divides RDX:RAX; the caller guarantees HIGH < DIVISOR so the quotient fits in 64 bits instead of faulting
+    __asm__("divq %4" : "=a"(quot), "=d"(*rem) : "a"(LOW), "d"(HIGH), "rm"(DIVISOR) : "cc");
+    return quot;
+}
+
+static OneTwoEight OneTwoEight_multiplyMul(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    return OneTwoEight_multiplyWith(LEFT, RIGHT, OneTwoEight_multiply64Mul);
+}
+
+static OneTwoEight OneTwoEight_multiplyFullMul(const OneTwoEight LEFT, const OneTwoEight RIGHT, OneTwoEight *HIGH) {
+    return OneTwoEight_multiplyFullWith(LEFT, RIGHT, HIGH, OneTwoEight_multiply64Mul);
+}
+
+static OneTwoEight OneTwoEight_divideMul(OneTwoEight LEFT, OneTwoEight RIGHT, OneTwoEight *REM_128) {
+    OneTwoEight quotHigh, rem;
+    OneTwoEight_t quot, remLSB;
+    int shift;
+    
+    // A 64-bit divisor takes at most two hardware divisions, schoolbook style with 64-bit digits
+    if (!RIGHT.msb) {
+        quot = OneTwoEight_divide64Mul(0, LEFT.msb, RIGHT.lsb, &remLSB);
+        quotHigh = (OneTwoEight){OneTwoEight_divide64Mul(remLSB, LEFT.lsb, RIGHT.lsb, &remLSB), quot};
+        *REM_128 = (OneTwoEight){remLSB, 0};
+        return quotHigh;
+    }
+    ONETWOEIGHT_PROFILE_SLOW_PATH();
+    // Otherwise the quotient fits in 64 bits. Estimate it from the divisor's leading 64 bits, normalized,
+    // against the dividend halved so the hardware division cannot overflow; the estimate is then off by at most one
+    // See Hacker's Delight, section 9-5: "Unsigned Doubleword Division from Long Division"
+    shift = __builtin_clzll(RIGHT.msb);
+    quot = OneTwoEight_divide64Mul(LEFT.msb >> 1, (LEFT.lsb >> 1) | (LEFT.msb << 63), OneTwoEight_leftShift(RIGHT, shift).msb, &remLSB);
+    quot = OneTwoEight_rightShift(OneTwoEight_leftShift(OneTwoEight_fromUInt64(quot), shift), 63).lsb;
+    if (quot) {
+        --quot;
+    }
+    rem = OneTwoEight_subtract(LEFT, OneTwoEight_multiplyMul(OneTwoEight_fromUInt64(quot), RIGHT));
+    if (OneTwoEight_greaterThanEqual(rem, RIGHT)) {
+        ++quot;
+        OneTwoEight_subtractAssign(&rem, RIGHT);
+    }
+    *REM_128 = rem;
+    return OneTwoEight_fromUInt64(quot);
+}
+
+static OneTwoEight OneTwoEight_multiplyBMI2(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    OneTwoEight product;
+    
+    // mulx reads RDX implicitly and leaves the flags alone
+    __asm__("mulxq %2, %0, %1" : "=r"(product.lsb), "=r"(product.msb) : "rm"(RIGHT.lsb), "d"(LEFT.lsb));
+    product.msb += (LEFT.lsb * RIGHT.msb) + (LEFT.msb * RIGHT.lsb);
+    return product;
+}
+
+static OneTwoEight OneTwoEight_multiplyFullBMI2(const OneTwoEight LEFT, const OneTwoEight RIGHT, OneTwoEight *HIGH) {
+    OneTwoEight_t digit0, digit1, digit2, digit3, low, high, zero;
+    
+    // Row for RIGHT.lsb sums on the CF chain (adcx), then the row for RIGHT.msb does too,
+    // while the OF chain (adox) folds the second row into the first one digit up
+    __asm__(
+        "xorl %k[zero], %k[zero]\n\t" // Clears both CF and OF
+        "movq %[rightLSB], %%rdx\n\t"
+        "mulxq %[leftLSB], %[digit0], %[digit1]\n\t"
+        "mulxq %[leftMSB], %[low], %[digit2]\n\t"
+        "adcxq %[low], %[digit1]\n\t"
+        "adcxq %[zero], %[digit2]\n\t"
+        "movq %[rightMSB], %%rdx\n\t"
+        "mulxq %[leftLSB], %[low], %[high]\n\t"
+        "mulxq %[leftMSB], %%rdx, %[digit3]\n\t"
+        "adcxq %%rdx, %[high]\n\t"
+        "adcxq %[zero], %[digit3]\n\t"
+        "adoxq %[low], %[digit1]\n\t"
+        "adoxq %[high], %[digit2]\n\t"
+        "adoxq %[zero], %[digit3]"
+        : [digit0] "=&r"(digit0), [digit1] "=&r"(digit1), [digit2] "=&r"(digit2), [digit3] "=&r"(digit3),
+          [low] "=&r"(low), [high] "=&r"(high), [zero] "=&r"(zero)
+        : [leftLSB] "r"(LEFT.lsb), [leftMSB] "r"(LEFT.msb), [rightLSB] "rm"(RIGHT.lsb), [rightMSB] "rm"(RIGHT.msb)
+        : "rdx", "cc");
+    if (HIGH) {
+        *HIGH = (OneTwoEight){digit2, digit3};
+    }
+    return (OneTwoEight){digit0, digit1};
+}
+
+static const OneTwoEightKernels ONETWOEIGHT_KERNELS_MUL = {"mul", OneTwoEight_kernelAlwaysSupported, OneTwoEight_multiplyMul, OneTwoEight_multiplyFullMul, OneTwoEight_divideMul};
+static const OneTwoEightKernels ONETWOEIGHT_KERNELS_BMI2 = {"bmi2", OneTwoEight_kernelBMI2Supported, OneTwoEight_multiplyBMI2, OneTwoEight_multiplyFullBMI2, OneTwoEight_divideMul};
+#endif // ONETWOEIGHT_HAS_X86_64_KERNELS
+
+// Best first
+static const OneTwoEightKernels *const ONETWOEIGHT_KERNELS[] = {
+#ifdef ONETWOEIGHT_HAS_X86_64_KERNELS
+    &ONETWOEIGHT_KERNELS_BMI2,
+    &ONETWOEIGHT_KERNELS_MUL,
+#endif // ONETWOEIGHT_HAS_X86_64_KERNELS
+    &ONETWOEIGHT_KERNELS_GENERIC
+};
+
+static const OneTwoEightKernels *OneTwoEight_kernels = &ONETWOEIGHT_KERNELS_GENERIC;
+
+#if defined(__GNUC__) || defined(__clang__)
+// Runs before main, while there is still only one thread; other compilers keep the generic kernels
+__attribute__((constructor)) static void OneTwoEight_selectKernels(void) {
+    const char *forced = getenv("ONETWOEIGHT_KERNEL");
+    size_t kernel;
+    
+    if (forced && *forced) {
+        for (kernel = 0; kernel < sizeof(ONETWOEIGHT_KERNELS) / sizeof(ONETWOEIGHT_KERNELS[0]); ++kernel) {
+            if (!strcmp(forced, ONETWOEIGHT_KERNELS[kernel]->name) && ONETWOEIGHT_KERNELS[kernel]->supported()) {
+                OneTwoEight_kernels = ONETWOEIGHT_KERNELS[kernel];
+                return;
+            }
+        }
+        fprintf(stderr, "Kernel %s is not available, choosing automatically.\n", forced);
+    }
+    // The generic kernels are last and always supported
+    for (kernel = 0; !ONETWOEIGHT_KERNELS[kernel]->supported(); ++kernel);
+    OneTwoEight_kernels = ONETWOEIGHT_KERNELS[kernel];
+}
+#endif // __GNUC__
+
+OneTwoEight OneTwoEight_multiply(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(multiply);
+    return OneTwoEight_kernels->multiply(LEFT, RIGHT);
+}
+
+OneTwoEight OneTwoEight_multiplyFull(const OneTwoEight LEFT, const OneTwoEight RIGHT, OneTwoEight *HIGH) {
+    ONETWOEIGHT_PROFILE_CALL(multiplyFull);
+    return OneTwoEight_kernels->multiplyFull(LEFT, RIGHT, HIGH);
+}
+
+OneTwoEight OneTwoEight_divide(OneTwoEight LEFT, OneTwoEight RIGHT, const bool USE_REM, OneTwoEight *REM_128) {
+    ONETWOEIGHT_PROFILE_CALL(divide);
+    // Division is usually the slowest basic operation of any integer type
+    OneTwoEight quot, rem;
+    
+    // Check for zero divisor, a classic undefined mathematical operation
+    if (!OneTwoEight_toBool(RIGHT)) {
+        fprintf(stderr, "Division by zero.\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    quot = OneTwoEight_kernels->divide(LEFT, RIGHT, &rem);
+    
     // See if the caller is requesting the remainder, and avoid null pointer dereferencing
     if (USE_REM && REM_128) {
-        *REM_128 = leftMSBit ? rem : LEFT;
+        *REM_128 = rem;
     }
     
     // Return the quotient
     return quot;
 }
 
+const char *OneTwoEight_kernelName(void) {
+    return OneTwoEight_kernels->name;
+}
+
 void OneTwoEight_addAssign(OneTwoEight *assigner, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(addAssign);
     *assigner = OneTwoEight_add(*assigner, RIGHT);
 }
 
 void OneTwoEight_subtractAssign(OneTwoEight *assigner, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(subtractAssign);
     *assigner = OneTwoEight_subtract(*assigner, RIGHT);
 }
 
 void OneTwoEight_multiplyAssign(OneTwoEight *assigner, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(multiplyAssign);
     *assigner = OneTwoEight_multiply(*assigner, RIGHT);
 }
 
 void OneTwoEight_divideAssign(OneTwoEight *assigner, OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(divideAssign);
     *assigner = OneTwoEight_divide(*assigner, RIGHT, false, NULL);
 }
 
 void OneTwoEight_modulusAssign(OneTwoEight *assigner, OneTwoEight RIGHT, OneTwoEight *REM_MOD) {
+    ONETWOEIGHT_PROFILE_CALL(modulusAssign);
     OneTwoEight_divide(*assigner, RIGHT, true, REM_MOD);
 }
 
 OneTwoEight OneTwoEight_bitwiseAnd(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(bitwiseAnd);
     return (OneTwoEight){(LEFT.lsb & RIGHT.lsb), (LEFT.msb & RIGHT.msb)};
 }
 
 OneTwoEight OneTwoEight_bitwiseOr(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(bitwiseOr);
     return (OneTwoEight){(LEFT.lsb | RIGHT.lsb), (LEFT.msb | RIGHT.msb)};
 }
 
 OneTwoEight OneTwoEight_bitwiseXor(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(bitwiseXor);
     return (OneTwoEight){(LEFT.lsb ^ RIGHT.lsb), (LEFT.msb ^ RIGHT.msb)};
 }
 
 OneTwoEight OneTwoEight_bitwiseNot(const OneTwoEight NUM) {
+    ONETWOEIGHT_PROFILE_CALL(bitwiseNot);
     return (OneTwoEight){~NUM.lsb, ~NUM.msb};
 }
 
 OneTwoEight OneTwoEight_leftShift(const OneTwoEight NUM, const int SHIFT_AMOUNT) {
+    ONETWOEIGHT_PROFILE_CALL(leftShift);
     // The standard states undefined behavior occurs when bit-shifting more than the size of the integer, or in negative amounts
     // My behavior is to return zero as per the condition from above, since it is trying to bit-shift beyond word sizes anyway
     if (!SHIFT_AMOUNT) { // Not shifting any bits
@@ -180,6 +553,7 @@ OneTwoEight OneTwoEight_leftShift(const OneTwoEight NUM, const int SHIFT_AMOUNT)
 }
 
 OneTwoEight OneTwoEight_rightShift(const OneTwoEight NUM, const int SHIFT_AMOUNT) {
+    ONETWOEIGHT_PROFILE_CALL(rightShift);
     if (!SHIFT_AMOUNT) {
         return NUM;
     }
@@ -193,26 +567,32 @@ OneTwoEight OneTwoEight_rightShift(const OneTwoEight NUM, const int SHIFT_AMOUNT
 }
 
 void OneTwoEight_bitwiseAndAssign(OneTwoEight *assigner, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(bitwiseAndAssign);
     *assigner = OneTwoEight_bitwiseAnd(*assigner, RIGHT);
 }
 
 void OneTwoEight_bitwiseOrAssign(OneTwoEight *assigner, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(bitwiseOrAssign);
     *assigner = OneTwoEight_bitwiseOr(*assigner, RIGHT);
 }
 
 void OneTwoEight_bitwiseXorAssign(OneTwoEight *assigner, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(bitwiseXorAssign);
     *assigner = OneTwoEight_bitwiseXor(*assigner, RIGHT);
 }
 
 void OneTwoEight_leftShiftAssign(OneTwoEight *assigner, const int SHIFT_AMOUNT) {
+    ONETWOEIGHT_PROFILE_CALL(leftShiftAssign);
     *assigner = OneTwoEight_leftShift(*assigner, SHIFT_AMOUNT);
 }
 
 void OneTwoEight_rightShiftAssign(OneTwoEight *assigner, const int SHIFT_AMOUNT) {
+    ONETWOEIGHT_PROFILE_CALL(rightShiftAssign);
     *assigner = OneTwoEight_rightShift(*assigner, SHIFT_AMOUNT);
 }
 
 void OneTwoEight_increment(OneTwoEight *NUM) {
+    ONETWOEIGHT_PROFILE_CALL(increment);
     // Increment LSB then check overflow
     if (!(++NUM->lsb)) {
         ++NUM->msb;
@@ -220,6 +600,7 @@ void OneTwoEight_increment(OneTwoEight *NUM) {
 }
 
 void OneTwoEight_decrement(OneTwoEight *NUM) {
+    ONETWOEIGHT_PROFILE_CALL(decrement);
     // Decrement LSB then check underflow
     if ((--NUM->lsb) == UINT64_MAX) {
         --NUM->msb;
@@ -227,12 +608,14 @@ void OneTwoEight_decrement(OneTwoEight *NUM) {
 }
 
 OneTwoEight OneTwoEight_preIncrement(OneTwoEight *NUM) {
+    ONETWOEIGHT_PROFILE_CALL(preIncrement);
     OneTwoEight_increment(NUM);
     // Return incremented value
     return *NUM;
 }
 
 OneTwoEight OneTwoEight_postIncrement(OneTwoEight *NUM) {
+    ONETWOEIGHT_PROFILE_CALL(postIncrement);
     // Save old values
     OneTwoEight oldNum = *NUM;
     OneTwoEight_increment(NUM);
@@ -241,53 +624,283 @@ OneTwoEight OneTwoEight_postIncrement(OneTwoEight *NUM) {
 }
 
 OneTwoEight OneTwoEight_preDecrement(OneTwoEight *NUM) {
+    ONETWOEIGHT_PROFILE_CALL(preDecrement);
     OneTwoEight_decrement(NUM);
     // Return decremented value
     return *NUM;
 }
 
 OneTwoEight OneTwoEight_postDecrement(OneTwoEight *NUM) {
+    ONETWOEIGHT_PROFILE_CALL(postDecrement);
     OneTwoEight oldNum = *NUM;
     OneTwoEight_decrement(NUM);
     return oldNum;
 }
 
 bool OneTwoEight_equal(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(equal);
     return (LEFT.lsb == RIGHT.lsb) && (LEFT.msb == RIGHT.msb);
 }
 
 bool OneTwoEight_notEqual(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(notEqual);
     return (LEFT.lsb != RIGHT.lsb) || (LEFT.msb != RIGHT.msb);
 }
 
 bool OneTwoEight_lessThan(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(lessThan);
     return (LEFT.msb < RIGHT.msb) || ((LEFT.msb == RIGHT.msb) && (LEFT.lsb < RIGHT.lsb));
 }
 
 bool OneTwoEight_lessThanEqual(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(lessThanEqual);
     return (LEFT.msb < RIGHT.msb) || ((LEFT.msb == RIGHT.msb) && (LEFT.lsb <= RIGHT.lsb));
 }
 
 bool OneTwoEight_greaterThan(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(greaterThan);
     return (LEFT.msb > RIGHT.msb) || ((LEFT.msb == RIGHT.msb) && (LEFT.lsb > RIGHT.lsb));
 }
 
 bool OneTwoEight_greaterThanEqual(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(greaterThanEqual);
     return (LEFT.msb > RIGHT.msb) || ((LEFT.msb == RIGHT.msb) && (LEFT.lsb >= RIGHT.lsb));
 }
 
 bool OneTwoEight_logicalAnd(const OneTwoEight LEFT, const OneTwoEight RIGHT)  {
+    ONETWOEIGHT_PROFILE_CALL(logicalAnd);
     return (LEFT.lsb && RIGHT.lsb) && (LEFT.msb && RIGHT.msb);
 }
 
 bool OneTwoEight_logicalOr(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(logicalOr);
     return (LEFT.lsb || RIGHT.lsb) || (LEFT.msb || RIGHT.msb);
 }
 
 bool OneTwoEight_logicalNot(const OneTwoEight NUM) {
+    ONETWOEIGHT_PROFILE_CALL(logicalNot);
     return !(NUM.lsb || NUM.msb);
 }
 
+// All ones for a negative number, zero otherwise
+static OneTwoEight_t OneTwoEight_signMask(const OneTwoEight NUM) {
+    return (OneTwoEight_t)(0) - (NUM.msb >> 63);
+}
+
+// (NUM ^ MASK) - MASK is -NUM when MASK is all ones, and NUM when it is zero
+static OneTwoEight OneTwoEight_negateIf(const OneTwoEight NUM, const OneTwoEight_t MASK) {
+    return OneTwoEight_subtract((OneTwoEight){NUM.lsb ^ MASK, NUM.msb ^ MASK}, (OneTwoEight){MASK, MASK});
+}
+
+static bool OneTwoEight_signedLess(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    // Flipping the sign bits maps signed order onto unsigned order
+    OneTwoEight_t leftMSB = LEFT.msb ^ 0x8000000000000000ull, rightMSB = RIGHT.msb ^ 0x8000000000000000ull;
+    
+    // Bitwise rather than logical operators, so neither half of the comparison short-circuits into a branch
+    return (leftMSB < rightMSB) | ((leftMSB == rightMSB) & (LEFT.lsb < RIGHT.lsb));
+}
+
+OneTwoEight OneTwoEight_sdivide(const OneTwoEight LEFT, const OneTwoEight RIGHT, const bool USE_REM, OneTwoEight *REM_128) {
+    ONETWOEIGHT_PROFILE_CALL(sdivide);
+    OneTwoEight_t leftMask = OneTwoEight_signMask(LEFT), rightMask = OneTwoEight_signMask(RIGHT);
+    OneTwoEight quot, rem;
+    
+    // Divide the magnitudes; the magnitude of ONETWOEIGHT_MIN is its own bit pattern read as unsigned
+    quot = OneTwoEight_divide(OneTwoEight_negateIf(LEFT, leftMask), OneTwoEight_negateIf(RIGHT, rightMask), true, &rem);
+    
+    // Truncating toward zero makes the quotient negative when the signs differ, and gives the remainder the dividend's sign
+    if (USE_REM && REM_128) {
+        *REM_128 = OneTwoEight_negateIf(rem, leftMask);
+    }
+    return OneTwoEight_negateIf(quot, leftMask ^ rightMask);
+}
+
+OneTwoEight OneTwoEight_smodulus(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(smodulus);
+    OneTwoEight rem;
+    
+    OneTwoEight_sdivide(LEFT, RIGHT, true, &rem);
+    return rem;
+}
+
+OneTwoEight OneTwoEight_arithmeticRightShift(const OneTwoEight NUM, const int SHIFT_AMOUNT) {
+    ONETWOEIGHT_PROFILE_CALL(arithmeticRightShift);
+    OneTwoEight_t mask = OneTwoEight_signMask(NUM);
+    OneTwoEight shifted;
+    
+    // Shifting the complement of a negative number brings in zeros, which turn into ones when complemented back
+    // Shifts that OneTwoEight_rightShift turns into zero therefore leave nothing but copies of the sign bit
+    shifted = OneTwoEight_rightShift((OneTwoEight){NUM.lsb ^ mask, NUM.msb ^ mask}, SHIFT_AMOUNT);
+    return (OneTwoEight){shifted.lsb ^ mask, shifted.msb ^ mask};
+}
+
+bool OneTwoEight_slessThan(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(slessThan);
+    return OneTwoEight_signedLess(LEFT, RIGHT);
+}
+
+bool OneTwoEight_slessThanEqual(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(slessThanEqual);
+    return !OneTwoEight_signedLess(RIGHT, LEFT);
+}
+
+bool OneTwoEight_sgreaterThan(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(sgreaterThan);
+    return OneTwoEight_signedLess(RIGHT, LEFT);
+}
+
+bool OneTwoEight_sgreaterThanEqual(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(sgreaterThanEqual);
+    return !OneTwoEight_signedLess(LEFT, RIGHT);
+}
+
+OneTwoEight OneTwoEight_negate(const OneTwoEight NUM) {
+    ONETWOEIGHT_PROFILE_CALL(negate);
+    return OneTwoEight_subtract(ONETWOEIGHT_ZERO, NUM);
+}
+
+OneTwoEight OneTwoEight_abs(const OneTwoEight NUM) {
+    ONETWOEIGHT_PROFILE_CALL(abs);
+    return OneTwoEight_negateIf(NUM, OneTwoEight_signMask(NUM));
+}
+
+OneTwoEight OneTwoEight_smin(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(smin);
+    // All ones selects LEFT, zero selects RIGHT
+    OneTwoEight_t mask = (OneTwoEight_t)(0) - OneTwoEight_signedLess(LEFT, RIGHT);
+    
+    return (OneTwoEight){RIGHT.lsb ^ ((LEFT.lsb ^ RIGHT.lsb) & mask), RIGHT.msb ^ ((LEFT.msb ^ RIGHT.msb) & mask)};
+}
+
+OneTwoEight OneTwoEight_smax(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(smax);
+    OneTwoEight_t mask = (OneTwoEight_t)(0) - OneTwoEight_signedLess(RIGHT, LEFT);
+    
+    return (OneTwoEight){RIGHT.lsb ^ ((LEFT.lsb ^ RIGHT.lsb) & mask), RIGHT.msb ^ ((LEFT.msb ^ RIGHT.msb) & mask)};
+}
+
+int OneTwoEight_sign(const OneTwoEight NUM) {
+    ONETWOEIGHT_PROFILE_CALL(sign);
+    // -1 | 1 is -1 for negatives, 0 | 1 is 1 for positives, and zero stays 0 | 0
+    return -(int)(NUM.msb >> 63) | ((NUM.lsb | NUM.msb) != 0);
+}
+
+static atomic_bool *OneTwoEight_atomicLock(const OneTwoEight *ATOMIC) {
+    // Objects are 16-byte aligned, so the low four address bits carry no information
+    atomic_bool *lock = &OneTwoEight_atomicStripes[((uintptr_t)(ATOMIC) >> 4) % ONETWOEIGHT_ATOMIC_STRIPES].locked;
+    
+    while (atomic_exchange_explicit(lock, true, memory_order_acquire)) {
+        // Spin on a plain load so the cache line stays shared until the holder lets go
+        while (atomic_load_explicit(lock, memory_order_relaxed));
+    }
+    return lock;
+}
+
+static void OneTwoEight_atomicUnlock(atomic_bool *lock) {
+    atomic_store_explicit(lock, false, memory_order_release);
+}
+
+static OneTwoEight OneTwoEight_atomicReplace(const OneTwoEight LEFT, const OneTwoEight RIGHT) {
+    (void)(LEFT);
+    return RIGHT;
+}
+
+// Atomically performs (a = OPERATION(a, b)) and returns the old value of a
+static OneTwoEight OneTwoEight_atomicFetchApply(OneTwoEight *ATOMIC, const OneTwoEight RIGHT, OneTwoEight (*OPERATION)(const OneTwoEight, const OneTwoEight)) {
+    OneTwoEight old;
+    atomic_bool *lock;
+    
+#ifdef ONETWOEIGHT_HAS_CMPXCHG16B
+    if (OneTwoEight_atomicIsLockFree()) {
+        // Guess from two plain halves so the first locked exchange usually succeeds; a torn guess just fails and hands back the current value
+        old = (OneTwoEight){__atomic_load_n(&ATOMIC->lsb, __ATOMIC_RELAXED), __atomic_load_n(&ATOMIC->msb, __ATOMIC_RELAXED)};
+        while (!OneTwoEight_atomicCompareExchange(ATOMIC, &old, OPERATION(old, RIGHT)));
+        return old;
+    }
+#endif // ONETWOEIGHT_HAS_CMPXCHG16B
+    lock = OneTwoEight_atomicLock(ATOMIC);
+    old = *ATOMIC;
+    *ATOMIC = OPERATION(old, RIGHT);
+    OneTwoEight_atomicUnlock(lock);
+    return old;
+}
+
+bool OneTwoEight_atomicIsLockFree(void) {
+#ifdef ONETWOEIGHT_HAS_CMPXCHG16B
+    // The very first x86-64 processors lack cmpxchg16b, so ask CPUID once and cache the answer
+    // 0 is unknown, 1 is absent, 2 is present; racing threads all store the same answer
+    static atomic_int hasCmpxchg16b;
+    unsigned eax, ebx, ecx, edx;
+    int cached = atomic_load_explicit(&hasCmpxchg16b, memory_order_relaxed);
+    
+    if (!cached) {
+        cached = (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_CMPXCHG16B)) ? 2 : 1;
+        atomic_store_explicit(&hasCmpxchg16b, cached, memory_order_relaxed);
+    }
+    return cached == 2;
+#else
+    return false;
+#endif // ONETWOEIGHT_HAS_CMPXCHG16B
+}
+
+OneTwoEight OneTwoEight_atomicLoad(OneTwoEight *ATOMIC) {
+    ONETWOEIGHT_PROFILE_CALL(atomicLoad);
+    OneTwoEight value = ONETWOEIGHT_ZERO;
+    atomic_bool *lock;
+    
+    if (OneTwoEight_atomicIsLockFree()) {
+        // There is no 16-byte atomic load; exchanging zero for zero is harmless and reads the value on failure
+        OneTwoEight_atomicCompareExchange(ATOMIC, &value, ONETWOEIGHT_ZERO);
+        return value;
+    }
+    lock = OneTwoEight_atomicLock(ATOMIC);
+    value = *ATOMIC;
+    OneTwoEight_atomicUnlock(lock);
+    return value;
+}
+
+void OneTwoEight_atomicStore(OneTwoEight *ATOMIC, const OneTwoEight VALUE) {
+    ONETWOEIGHT_PROFILE_CALL(atomicStore);
+    OneTwoEight_atomicFetchApply(ATOMIC, VALUE, OneTwoEight_atomicReplace);
+}
+
+bool OneTwoEight_atomicCompareExchange(OneTwoEight *ATOMIC, OneTwoEight *expected, const OneTwoEight DESIRED) {
+    ONETWOEIGHT_PROFILE_CALL(atomicCompareExchange);
+    atomic_bool *lock;
+    bool swapped;
+    
+#ifdef ONETWOEIGHT_HAS_CMPXCHG16B
+    if (OneTwoEight_atomicIsLockFree()) {
+        // Compares RDX:RAX against memory; stores RCX:RBX on a match, otherwise loads memory into RDX:RAX
+        // The lock prefix makes it a full barrier, so this is sequentially consistent
+        __asm__ __volatile__("lock cmpxchg16b %1\n\tsete %0"
+            : "=q"(swapped), "+m"(*ATOMIC), "+a"(expected->lsb), "+d"(expected->msb)
+            : "b"(DESIRED.lsb), "c"(DESIRED.msb)
+            : "memory", "cc");
+        return swapped;
+    }
+#endif // ONETWOEIGHT_HAS_CMPXCHG16B
+    lock = OneTwoEight_atomicLock(ATOMIC);
+    if ((swapped = OneTwoEight_equal(*ATOMIC, *expected))) {
+        *ATOMIC = DESIRED;
+    }
+    else {
+        *expected = *ATOMIC;
+    }
+    OneTwoEight_atomicUnlock(lock);
+    return swapped;
+}
+
+OneTwoEight OneTwoEight_atomicFetchAdd(OneTwoEight *ATOMIC, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(atomicFetchAdd);
+    return OneTwoEight_atomicFetchApply(ATOMIC, RIGHT, OneTwoEight_add);
+}
+
+OneTwoEight OneTwoEight_atomicFetchOr(OneTwoEight *ATOMIC, const OneTwoEight RIGHT) {
+    ONETWOEIGHT_PROFILE_CALL(atomicFetchOr);
+    return OneTwoEight_atomicFetchApply(ATOMIC, RIGHT, OneTwoEight_bitwiseOr);
+}
+
 OneTwoEight OneTwoEight_fromBool(const bool BOOL) {
     return (OneTwoEight){BOOL, 0};
 }
@@ -440,6 +1053,56 @@ uint64_t OneTwoEight_toUInt64(const OneTwoEight ONETWOEIGHT) {
     return (uint64_t)(ONETWOEIGHT.lsb);
 }
 
+#ifdef ONETWOEIGHT_PROFILE
+OneTwoEightProfile OneTwoEight_profileMerge(void) {
+    OneTwoEightProfile profile;
+    OneTwoEightProfileThread *thread;
+    
+    OneTwoEight_profileAcquire();
+    profile = OneTwoEight_profileRetired;
+    for (thread = OneTwoEight_profileThreads; thread; thread = thread->next) {
+        OneTwoEight_profileAdd(&profile, thread);
+    }
+    OneTwoEight_profileRelease();
+    return profile;
+}
+
+void OneTwoEight_profileDump(FILE *stream) {
+    static const char *const NAMES[ONETWOEIGHT_PROFILE_OPERATOR_COUNT] = {
+#define ONETWOEIGHT_PROFILE_NAME(NAME) "OneTwoEight_" #NAME,
+        ONETWOEIGHT_PROFILE_OPERATORS(ONETWOEIGHT_PROFILE_NAME)
+#undef ONETWOEIGHT_PROFILE_NAME
+    };
+    OneTwoEightProfile profile = OneTwoEight_profileMerge();
+    int order[ONETWOEIGHT_PROFILE_OPERATOR_COUNT], sorted, which;
+    uint64_t totalCalls = 0;
+    
+    // Insertion sort by call count, busiest first; there are only a few dozen operators
+    for (sorted = 0; sorted < ONETWOEIGHT_PROFILE_OPERATOR_COUNT; ++sorted) {
+        totalCalls += profile.calls[sorted];
+        for (which = sorted; which && (profile.calls[order[which - 1]] < profile.calls[sorted]); --which) {
+            order[which] = order[which - 1];
+        }
+        order[which] = sorted;
+    }
+#ifdef ONETWOEIGHT_PROFILE_CYCLES
+    fprintf(stream, "%-36s %20s %8s %20s %12s\n", "Operator", "Calls", "Share", "Cycles", "Cycles/call");
+#else
+    fprintf(stream, "%-36s %20s %8s\n", "Operator", "Calls", "Share");
+#endif // ONETWOEIGHT_PROFILE_CYCLES
+    for (sorted = 0; (sorted < ONETWOEIGHT_PROFILE_OPERATOR_COUNT) && profile.calls[order[sorted]]; ++sorted) {
+        which = order[sorted];
+#ifdef ONETWOEIGHT_PROFILE_CYCLES
+        fprintf(stream, "%-36s %20" PRIu64 " %7.2f%% %20" PRIu64 " %12.1f\n", NAMES[which], profile.calls[which],
+            100.0 * profile.calls[which] / totalCalls, profile.cycles[which], (double)(profile.cycles[which]) / profile.calls[which]);
+#else
+        fprintf(stream, "%-36s %20" PRIu64 " %7.2f%%\n", NAMES[which], profile.calls[which], 100.0 * profile.calls[which] / totalCalls);
+#endif // ONETWOEIGHT_PROFILE_CYCLES
+    }
+    fprintf(stream, "Division slow path (%s kernel): %" PRIu64 " times\n", OneTwoEight_kernelName(), profile.divideSlowPaths);
+}
+#endif // ONETWOEIGHT_PROFILE
+
 void OneTwoEight_print(const OneTwoEight NUM, const bool SIGN) {
     OneTwoEight basePrint = NUM, baseDigit;
     int digit128Index = 0, digits128[39];
@@ -455,7 +1118,7 @@ void OneTwoEight_print(const OneTwoEight NUM, const bool SIGN) {
         }
         // Compute decimal digits
         while (OneTwoEight_toBool(basePrint)) {
-            OneTwoEight_modulusAssign(&basePrint, OneTwoEight_fromInt(10), &baseDigit);
+            basePrint = OneTwoEight_divide(basePrint, OneTwoEight_fromInt(10), true, &baseDigit);
             digits128[digit128Index++] = OneTwoEight_toInt(baseDigit);
         }
         // Print the digits
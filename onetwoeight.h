@@ -22,6 +22,9 @@ static const OneTwoEight ONETWOEIGHT_UMAX = (OneTwoEight){0xffffffffffffffffull,
 static const OneTwoEight ONETWOEIGHT_ZERO = (OneTwoEight){0x0ull, 0x0ull}; // ONETWOEIGHT_UMIN
 static const OneTwoEight ONETWOEIGHT_ONE = (OneTwoEight){0x1ull, 0x0ull};
 
+// Objects passed to the atomic functions must be declared with this; cmpxchg16b faults on misaligned operands
+#define ONETWOEIGHT_ALIGNED _Alignas(16)
+
 /*
     Functions handling all C operators on 128-bit integers
     Operator overloading is only supported in C++, so use operator names for functions
@@ -30,6 +33,7 @@ static const OneTwoEight ONETWOEIGHT_ONE = (OneTwoEight){0x1ull, 0x0ull};
 OneTwoEight OneTwoEight_add(const OneTwoEight, const OneTwoEight); // (a + b)
 OneTwoEight OneTwoEight_subtract(const OneTwoEight, const OneTwoEight); // (a - b)
 OneTwoEight OneTwoEight_multiply(const OneTwoEight, const OneTwoEight); // (a * b)
+OneTwoEight OneTwoEight_multiplyFull(const OneTwoEight, const OneTwoEight, OneTwoEight*); // (a * b) to 256 bits; returns the low half and stores the high half if non-null
 OneTwoEight OneTwoEight_divide(OneTwoEight, OneTwoEight, const bool, OneTwoEight*); // (a / b)
 OneTwoEight OneTwoEight_modulus(OneTwoEight, OneTwoEight, OneTwoEight*); // (a % b)
 // Arithmetic with assignment
@@ -69,6 +73,27 @@ bool OneTwoEight_greaterThanEqual(const OneTwoEight, const OneTwoEight); // (a >
 bool OneTwoEight_logicalAnd(const OneTwoEight, const OneTwoEight); // (a && b)
 bool OneTwoEight_logicalOr(const OneTwoEight, const OneTwoEight); // (a || b)
 bool OneTwoEight_logicalNot(const OneTwoEight); // (!a)
+// Signed, treating the value as two's complement; signs are handled with masks rather than branches
+OneTwoEight OneTwoEight_sdivide(const OneTwoEight, const OneTwoEight, const bool, OneTwoEight*); // (a / b) Truncates toward zero; ONETWOEIGHT_MIN / -1 wraps to ONETWOEIGHT_MIN
+OneTwoEight OneTwoEight_smodulus(const OneTwoEight, const OneTwoEight); // (a % b) Takes the sign of a
+OneTwoEight OneTwoEight_arithmeticRightShift(const OneTwoEight, const int); // (a >> b) Shifts in copies of the sign bit; amounts outside 0 to 127 leave only those
+bool OneTwoEight_slessThan(const OneTwoEight, const OneTwoEight); // (a < b)
+bool OneTwoEight_slessThanEqual(const OneTwoEight, const OneTwoEight); // (a <= b)
+bool OneTwoEight_sgreaterThan(const OneTwoEight, const OneTwoEight); // (a > b)
+bool OneTwoEight_sgreaterThanEqual(const OneTwoEight, const OneTwoEight); // (a >= b)
+OneTwoEight OneTwoEight_negate(const OneTwoEight); // (-a)
+OneTwoEight OneTwoEight_abs(const OneTwoEight); // abs(a) ONETWOEIGHT_MIN stays ONETWOEIGHT_MIN
+OneTwoEight OneTwoEight_smin(const OneTwoEight, const OneTwoEight); // (a < b ? a : b)
+OneTwoEight OneTwoEight_smax(const OneTwoEight, const OneTwoEight); // (a > b ? a : b)
+int OneTwoEight_sign(const OneTwoEight); // -1, 0 or 1
+// Atomic, sequentially consistent; lock-free through cmpxchg16b when supported, else backed by striped spinlocks
+// Build with -DONETWOEIGHT_ATOMIC_LOCKS to always take the spinlock path, so it can be tested on x86-64 too
+bool OneTwoEight_atomicIsLockFree(void); // atomic_is_lock_free(&a)
+OneTwoEight OneTwoEight_atomicLoad(OneTwoEight*); // atomic_load(&a)
+void OneTwoEight_atomicStore(OneTwoEight*, const OneTwoEight); // atomic_store(&a, b)
+bool OneTwoEight_atomicCompareExchange(OneTwoEight*, OneTwoEight*, const OneTwoEight); // atomic_compare_exchange_strong(&a, &b, c)
+OneTwoEight OneTwoEight_atomicFetchAdd(OneTwoEight*, const OneTwoEight); // atomic_fetch_add(&a, b)
+OneTwoEight OneTwoEight_atomicFetchOr(OneTwoEight*, const OneTwoEight); // atomic_fetch_or(&a, b)
 
 /* Conversations to OneTwoEight */
 // Other integral types
@@ -116,6 +141,44 @@ uint32_t OneTwoEight_toUInt32(const OneTwoEight); // (uint32_t)(OneTwoEight)
 int64_t OneTwoEight_toInt64(const OneTwoEight); // (int64_t)(OneTwoEight)
 uint64_t OneTwoEight_toUInt64(const OneTwoEight); // (uint64_t)(OneTwoEight)
 
+/*
+    Opt-in profiling: build with -DONETWOEIGHT_PROFILE under GCC or Clang to count calls to every operator above, and how often division
+    leaves the fast path of the kernel in use. Add -DONETWOEIGHT_PROFILE_CYCLES on x86 to also total rdtsc cycles per operator.
+    Only calls made from outside the library count: an operator's internal use of others is part of its own calls and cycles.
+    Counters are kept per thread and summed on demand; where ONETWOEIGHT_HAS_THREADS says C11 threads exist, an exiting thread
+    folds its counters into a shared total and frees them. Without the flag the operators carry no profiling code at all.
+*/
+#ifdef ONETWOEIGHT_PROFILE
+#define ONETWOEIGHT_PROFILE_OPERATORS(X) \
+    X(add) X(subtract) X(multiply) X(multiplyFull) X(divide) X(addAssign) X(subtractAssign) X(multiplyAssign) X(divideAssign) \
+    X(modulusAssign) X(bitwiseAnd) X(bitwiseOr) X(bitwiseXor) X(bitwiseNot) X(leftShift) X(rightShift) \
+    X(bitwiseAndAssign) X(bitwiseOrAssign) X(bitwiseXorAssign) X(leftShiftAssign) X(rightShiftAssign) \
+    X(increment) X(decrement) X(preIncrement) X(postIncrement) X(preDecrement) X(postDecrement) X(equal) \
+    X(notEqual) X(lessThan) X(lessThanEqual) X(greaterThan) X(greaterThanEqual) X(logicalAnd) X(logicalOr) \
+    X(logicalNot) X(sdivide) X(smodulus) X(arithmeticRightShift) X(slessThan) X(slessThanEqual) X(sgreaterThan) \
+    X(sgreaterThanEqual) X(negate) X(abs) X(smin) X(smax) X(sign) X(atomicLoad) X(atomicStore) X(atomicCompareExchange) \
+    X(atomicFetchAdd) X(atomicFetchOr)
+
+typedef enum OneTwoEightProfileOperator {
+#define ONETWOEIGHT_PROFILE_ENUMERATE(NAME) ONETWOEIGHT_PROFILE_##NAME,
+    ONETWOEIGHT_PROFILE_OPERATORS(ONETWOEIGHT_PROFILE_ENUMERATE)
+#undef ONETWOEIGHT_PROFILE_ENUMERATE
+    ONETWOEIGHT_PROFILE_OPERATOR_COUNT
+} OneTwoEightProfileOperator;
+
+typedef struct OneTwoEightProfile {
+    uint64_t calls[ONETWOEIGHT_PROFILE_OPERATOR_COUNT];
+    uint64_t cycles[ONETWOEIGHT_PROFILE_OPERATOR_COUNT]; // Zero without ONETWOEIGHT_PROFILE_CYCLES
+    uint64_t divideSlowPaths; // Every division, also inside other operators; generic kernel: dividend with its top bit set; mul and bmi2: divisor wider than 64 bits
+} OneTwoEightProfile;
+
+OneTwoEightProfile OneTwoEight_profileMerge(void); // Sum of every thread's counters so far, including threads that have exited
+void OneTwoEight_profileDump(FILE*); // Print the merged profile, busiest operator first
+#endif // ONETWOEIGHT_PROFILE
+
+// Name of the multiplication and division kernels in use: generic, mul or bmi2; ONETWOEIGHT_KERNEL in the environment overrides it
+const char *OneTwoEight_kernelName(void);
+
 // Generic print function
 void OneTwoEight_print(const OneTwoEight, const bool);
 
@@ -0,0 +1,550 @@
+/*
+    Copyright (C) 2022 TheTrustedComputer
+*/
+
+#include "onetwoeightexpr.h"
+
+#define ONETWOEIGHTEXPR_LEVELS 6 // Binary precedence levels
+
+typedef enum OneTwoEightExprNodeKind {
+    ONETWOEIGHTEXPR_NODE_CONSTANT, ONETWOEIGHTEXPR_NODE_COLUMN, ONETWOEIGHTEXPR_NODE_UNARY, ONETWOEIGHTEXPR_NODE_BINARY
+} OneTwoEightExprNodeKind;
+
+typedef struct OneTwoEightExprNode {
+    OneTwoEightExprNodeKind kind;
+    OneTwoEightExprOpcode opcode;
+    int left, right, column;
+    OneTwoEight value;
+} OneTwoEightExprNode;
+
+typedef struct OneTwoEightExprParser {
+    const char *cursor;
+    const char *const *NAMES;
+    int nameCount, nodeCount;
+    OneTwoEightExprNode *nodes; // Every node consumes at least one character, so the text length bounds their number
+    const char *error; // First problem found; parsing unwinds without looking further
+} OneTwoEightExprParser;
+
+// A slice of the rows for one thread, starting and ending on block boundaries
+typedef struct OneTwoEightExprPartition {
+    const OneTwoEightExpr *EXPR;
+    const OneTwoEightColumn *COLUMNS, *OUTPUT;
+    size_t first, last;
+} OneTwoEightExprPartition;
+
+// Binary operators by precedence, loosest first
+static const struct {
+    const char *symbol;
+    OneTwoEightExprOpcode opcode;
+} ONETWOEIGHTEXPR_OPERATORS[ONETWOEIGHTEXPR_LEVELS][4] = {
+    {{"|", ONETWOEIGHTEXPR_OR}, {NULL}},
+    {{"^", ONETWOEIGHTEXPR_XOR}, {NULL}},
+    {{"&", ONETWOEIGHTEXPR_AND}, {NULL}},
+    {{"<<", ONETWOEIGHTEXPR_LEFT_SHIFT}, {">>", ONETWOEIGHTEXPR_RIGHT_SHIFT}, {NULL}},
+    {{"+", ONETWOEIGHTEXPR_ADD}, {"-", ONETWOEIGHTEXPR_SUBTRACT}, {NULL}},
+    {{"*", ONETWOEIGHTEXPR_MULTIPLY}, {"/", ONETWOEIGHTEXPR_DIVIDE}, {"%", ONETWOEIGHTEXPR_MODULUS}, {NULL}}
+};
+
+static int OneTwoEightExpr_shiftAmount(const OneTwoEight AMOUNT) {
+    // Anything from 128 up shifts every bit out, which the library's shifts do for 128
+    return (AMOUNT.msb || (AMOUNT.lsb >= 128)) ? 128 : (int)(AMOUNT.lsb);
+}
+
+// One row of one instruction; false when the row turns null
+static bool OneTwoEightExpr_apply(const OneTwoEightExprOpcode OPCODE, const OneTwoEight LEFT, const OneTwoEight RIGHT, OneTwoEight *result) {
+    switch (OPCODE) {
+    case ONETWOEIGHTEXPR_ADD:
+        *result = OneTwoEight_add(LEFT, RIGHT);
+        break;
+    case ONETWOEIGHTEXPR_SUBTRACT:
+        *result = OneTwoEight_subtract(LEFT, RIGHT);
+        break;
+    case ONETWOEIGHTEXPR_MULTIPLY:
+        *result = OneTwoEight_multiply(LEFT, RIGHT);
+        break;
+    case ONETWOEIGHTEXPR_DIVIDE:
+    case ONETWOEIGHTEXPR_MODULUS:
+        // A zero divisor nulls the row instead of ending the program like OneTwoEight_divide does
+        if (!OneTwoEight_toBool(RIGHT)) {
+            *result = ONETWOEIGHT_ZERO;
+            return false;
+        }
+        if (OPCODE == ONETWOEIGHTEXPR_DIVIDE) {
+            *result = OneTwoEight_divide(LEFT, RIGHT, false, NULL);
+        }
+        else {
+            OneTwoEight_divide(LEFT, RIGHT, true, result);
+        }
+        break;
+    case ONETWOEIGHTEXPR_AND:
+        *result = OneTwoEight_bitwiseAnd(LEFT, RIGHT);
+        break;
+    case ONETWOEIGHTEXPR_OR:
+        *result = OneTwoEight_bitwiseOr(LEFT, RIGHT);
+        break;
+    case ONETWOEIGHTEXPR_XOR:
+        *result = OneTwoEight_bitwiseXor(LEFT, RIGHT);
+        break;
+    case ONETWOEIGHTEXPR_LEFT_SHIFT:
+        *result = OneTwoEight_leftShift(LEFT, OneTwoEightExpr_shiftAmount(RIGHT));
+        break;
+    case ONETWOEIGHTEXPR_RIGHT_SHIFT:
+        *result = OneTwoEight_rightShift(LEFT, OneTwoEightExpr_shiftAmount(RIGHT));
+        break;
+    case ONETWOEIGHTEXPR_NEGATE:
+        *result = OneTwoEight_negate(LEFT);
+        break;
+    case ONETWOEIGHTEXPR_NOT:
+        *result = OneTwoEight_bitwiseNot(LEFT);
+    }
+    return true;
+}
+
+static void OneTwoEightExpr_skipSpace(OneTwoEightExprParser *parser) {
+    while (isspace((unsigned char)(*parser->cursor))) {
+        ++parser->cursor;
+    }
+}
+
+static int OneTwoEightExpr_fail(OneTwoEightExprParser *parser, const char *ERROR) {
+    if (!parser->error) {
+        parser->error = ERROR;
+    }
+    return 0;
+}
+
+static int OneTwoEightExpr_addNode(OneTwoEightExprParser *parser, const OneTwoEightExprNode NODE) {
+    parser->nodes[parser->nodeCount] = NODE;
+    return parser->nodeCount++;
+}
+
+static int OneTwoEightExpr_unary(OneTwoEightExprParser *parser, const OneTwoEightExprOpcode OPCODE, const int OPERAND) {
+    OneTwoEightExprNode *operand = &parser->nodes[OPERAND];
+    
+    // Fold constants in place
+    if (operand->kind == ONETWOEIGHTEXPR_NODE_CONSTANT) {
+        OneTwoEightExpr_apply(OPCODE, operand->value, operand->value, &operand->value);
+        return OPERAND;
+    }
+    return OneTwoEightExpr_addNode(parser, (OneTwoEightExprNode){ONETWOEIGHTEXPR_NODE_UNARY, OPCODE, OPERAND, OPERAND, 0, ONETWOEIGHT_ZERO});
+}
+
+static int OneTwoEightExpr_binary(OneTwoEightExprParser *parser, const OneTwoEightExprOpcode OPCODE, const int LEFT, const int RIGHT) {
+    OneTwoEightExprNode *left = &parser->nodes[LEFT], *right = &parser->nodes[RIGHT];
+    OneTwoEight folded;
+    
+    // Fold two constants into the left one, unless that would divide by zero; that stays for every row to turn null at run time
+    if ((left->kind == ONETWOEIGHTEXPR_NODE_CONSTANT) && (right->kind == ONETWOEIGHTEXPR_NODE_CONSTANT) && OneTwoEightExpr_apply(OPCODE, left->value, right->value, &folded)) {
+        left->value = folded;
+        return LEFT;
+    }
+    return OneTwoEightExpr_addNode(parser, (OneTwoEightExprNode){ONETWOEIGHTEXPR_NODE_BINARY, OPCODE, LEFT, RIGHT, 0, ONETWOEIGHT_ZERO});
+}
+
+static int OneTwoEightExpr_parseBinary(OneTwoEightExprParser*, const int);
+
+static int OneTwoEightExpr_parsePrimary(OneTwoEightExprParser *parser) {
+    OneTwoEight value = ONETWOEIGHT_ZERO, base = OneTwoEight_fromInt(10), digit;
+    const char *start;
+    int node, name;
+    
+    OneTwoEightExpr_skipSpace(parser);
+    if (*parser->cursor == '(') {
+        ++parser->cursor;
+        node = OneTwoEightExpr_parseBinary(parser, 0);
+        OneTwoEightExpr_skipSpace(parser);
+        if (*parser->cursor != ')') {
+            return OneTwoEightExpr_fail(parser, "expected )");
+        }
+        ++parser->cursor;
+        return node;
+    }
+    if (isdigit((unsigned char)(*parser->cursor))) {
+        if ((parser->cursor[0] == '0') && (tolower((unsigned char)(parser->cursor[1])) == 'x') && isxdigit((unsigned char)(parser->cursor[2]))) {
+            base = OneTwoEight_fromInt(16);
+            parser->cursor += 2;
+        }
+        for (; (OneTwoEight_toInt(base) == 16) ? isxdigit((unsigned char)(*parser->cursor)) : isdigit((unsigned char)(*parser->cursor)); ++parser->cursor) {
+            digit = OneTwoEight_fromInt(isdigit((unsigned char)(*parser->cursor)) ? (*parser->cursor - '0') : (tolower((unsigned char)(*parser->cursor)) - 'a' + 10));
+            // value * base + digit must not pass ONETWOEIGHT_UMAX
+            if (OneTwoEight_greaterThan(value, OneTwoEight_divide(OneTwoEight_subtract(ONETWOEIGHT_UMAX, digit), base, false, NULL))) {
+                return OneTwoEightExpr_fail(parser, "literal does not fit in 128 bits");
+            }
+            value = OneTwoEight_add(OneTwoEight_multiply(value, base), digit);
+        }
+        return OneTwoEightExpr_addNode(parser, (OneTwoEightExprNode){ONETWOEIGHTEXPR_NODE_CONSTANT, ONETWOEIGHTEXPR_ADD, 0, 0, 0, value});
+    }
+    if (isalpha((unsigned char)(*parser->cursor)) || (*parser->cursor == '_')) {
+        for (start = parser->cursor; isalnum((unsigned char)(*parser->cursor)) || (*parser->cursor == '_'); ++parser->cursor);
+        for (name = 0; name < parser->nameCount; ++name) {
+            if ((strlen(parser->NAMES[name]) == (size_t)(parser->cursor - start)) && !strncmp(parser->NAMES[name], start, parser->cursor - start)) {
+                return OneTwoEightExpr_addNode(parser, (OneTwoEightExprNode){ONETWOEIGHTEXPR_NODE_COLUMN, ONETWOEIGHTEXPR_ADD, 0, 0, name, ONETWOEIGHT_ZERO});
+            }
+        }
+        parser->cursor = start;
+        return OneTwoEightExpr_fail(parser, "unknown column");
+    }
+    return OneTwoEightExpr_fail(parser, "expected a value");
+}
+
+static int OneTwoEightExpr_parseUnary(OneTwoEightExprParser *parser) {
+    OneTwoEightExprOpcode opcode;
+    int operand;
+    
+    OneTwoEightExpr_skipSpace(parser);
+    switch (*parser->cursor) {
+    case '-':
+        opcode = ONETWOEIGHTEXPR_NEGATE;
+        break;
+    case '~':
+        opcode = ONETWOEIGHTEXPR_NOT;
+        break;
+    case '+':
+        ++parser->cursor;
+        return OneTwoEightExpr_parseUnary(parser);
+    default:
+        return OneTwoEightExpr_parsePrimary(parser);
+    }
+    ++parser->cursor;
+    operand = OneTwoEightExpr_parseUnary(parser);
+    // A failed operand comes back as node 0, which may never have been written
+    return parser->error ? 0 : OneTwoEightExpr_unary(parser, opcode, operand);
+}
+
+static int OneTwoEightExpr_parseBinary(OneTwoEightExprParser *parser, const int LEVEL) {
+    int left, right, symbol;
+    size_t length;
+    
+    if (LEVEL == ONETWOEIGHTEXPR_LEVELS) {
+        return OneTwoEightExpr_parseUnary(parser);
+    }
+    // Left associative: keep folding operands of this level into the left side
+    for (left = OneTwoEightExpr_parseBinary(parser, LEVEL + 1); !parser->error; left = OneTwoEightExpr_binary(parser, ONETWOEIGHTEXPR_OPERATORS[LEVEL][symbol].opcode, left, right)) {
+        OneTwoEightExpr_skipSpace(parser);
+        for (symbol = 0; ONETWOEIGHTEXPR_OPERATORS[LEVEL][symbol].symbol; ++symbol) {
+            length = strlen(ONETWOEIGHTEXPR_OPERATORS[LEVEL][symbol].symbol);
+            if (!strncmp(parser->cursor, ONETWOEIGHTEXPR_OPERATORS[LEVEL][symbol].symbol, length)) {
+                break;
+            }
+        }
+        if (!ONETWOEIGHTEXPR_OPERATORS[LEVEL][symbol].symbol) {
+            break;
+        }
+        parser->cursor += length;
+        if (parser->error || ((right = OneTwoEightExpr_parseBinary(parser, LEVEL + 1)), parser->error)) {
+            break;
+        }
+    }
+    return left;
+}
+
+static OneTwoEightExprOperand OneTwoEightExpr_emit(OneTwoEightExpr *expr, const OneTwoEightExprNode *NODES, const int NODE, bool *registersBusy) {
+    const OneTwoEightExprNode *node = &NODES[NODE];
+    OneTwoEightExprInstruction instruction;
+    int index;
+    
+    switch (node->kind) {
+    case ONETWOEIGHTEXPR_NODE_CONSTANT:
+        for (index = 0; (index < expr->constantCount) && OneTwoEight_notEqual(expr->constants[index], node->value); ++index);
+        if (index == expr->constantCount) {
+            expr->constants[expr->constantCount++] = node->value;
+        }
+        return (OneTwoEightExprOperand){ONETWOEIGHTEXPR_CONSTANT, index};
+    case ONETWOEIGHTEXPR_NODE_COLUMN:
+        expr->columnsRead[node->column] = true;
+        return (OneTwoEightExprOperand){ONETWOEIGHTEXPR_COLUMN, node->column};
+    default:
+        break;
+    }
+    instruction.opcode = node->opcode;
+    instruction.left = OneTwoEightExpr_emit(expr, NODES, node->left, registersBusy);
+    instruction.right = (node->kind == ONETWOEIGHTEXPR_NODE_BINARY) ? OneTwoEightExpr_emit(expr, NODES, node->right, registersBusy) : instruction.left;
+    
+    // Operands are used up by this instruction, so their registers are free to take its result
+    if (instruction.left.source == ONETWOEIGHTEXPR_REGISTER) {
+        registersBusy[instruction.left.index] = false;
+    }
+    if (instruction.right.source == ONETWOEIGHTEXPR_REGISTER) {
+        registersBusy[instruction.right.index] = false;
+    }
+    for (index = 0; registersBusy[index]; ++index);
+    registersBusy[index] = true;
+    expr->registerCount = (index >= expr->registerCount) ? (index + 1) : expr->registerCount;
+    instruction.destination = index;
+    expr->instructions[expr->instructionCount++] = instruction;
+    return (OneTwoEightExprOperand){ONETWOEIGHTEXPR_REGISTER, index};
+}
+
+// Start of the rows an operand reads in the current block; constants live after the registers, already repeated across a block
+static OneTwoEight_t *OneTwoEightExpr_half(const OneTwoEightExpr *EXPR, const OneTwoEightExprOperand OPERAND, const bool HIGH, const OneTwoEightColumn *COLUMNS, OneTwoEight_t *scratch, const size_t START) {
+    switch (OPERAND.source) {
+    case ONETWOEIGHTEXPR_REGISTER:
+        return scratch + (2 * OPERAND.index + HIGH) * ONETWOEIGHTEXPR_BLOCK;
+    case ONETWOEIGHTEXPR_CONSTANT:
+        return scratch + (2 * (EXPR->registerCount + OPERAND.index) + HIGH) * ONETWOEIGHTEXPR_BLOCK;
+    default:
+        return (HIGH ? COLUMNS[OPERAND.index].msb : COLUMNS[OPERAND.index].lsb) + START;
+    }
+}
+
+static void OneTwoEightExpr_run(const OneTwoEightExprOpcode OPCODE, OneTwoEight_t *lsb, OneTwoEight_t *msb, const OneTwoEight_t *LEFT_LSB, const OneTwoEight_t *LEFT_MSB,
+                                const OneTwoEight_t *RIGHT_LSB, const OneTwoEight_t *RIGHT_MSB, bool *valid, const size_t ROWS) {
+    OneTwoEight_t low;
+    size_t row;
+    
+    // The cheap operators work on the halves directly, branch-free, so the compiler can vectorize them
+    // The destination may share a register with an operand, so each row reads everything before writing
+    switch (OPCODE) {
+    case ONETWOEIGHTEXPR_ADD:
+        for (row = 0; row < ROWS; ++row) {
+            low = LEFT_LSB[row] + RIGHT_LSB[row];
+            msb[row] = LEFT_MSB[row] + RIGHT_MSB[row] + (low < LEFT_LSB[row]);
+            lsb[row] = low;
+        }
+        return;
+    case ONETWOEIGHTEXPR_SUBTRACT:
+        for (row = 0; row < ROWS; ++row) {
+            low = LEFT_LSB[row] - RIGHT_LSB[row];
+            msb[row] = LEFT_MSB[row] - RIGHT_MSB[row] - (low > LEFT_LSB[row]);
+            lsb[row] = low;
+        }
+        return;
+    case ONETWOEIGHTEXPR_AND:
+        for (row = 0; row < ROWS; ++row) {
+            lsb[row] = LEFT_LSB[row] & RIGHT_LSB[row];
+            msb[row] = LEFT_MSB[row] & RIGHT_MSB[row];
+        }
+        return;
+    case ONETWOEIGHTEXPR_OR:
+        for (row = 0; row < ROWS; ++row) {
+            lsb[row] = LEFT_LSB[row] | RIGHT_LSB[row];
+            msb[row] = LEFT_MSB[row] | RIGHT_MSB[row];
+        }
+        return;
+    case ONETWOEIGHTEXPR_XOR:
+        for (row = 0; row < ROWS; ++row) {
+            lsb[row] = LEFT_LSB[row] ^ RIGHT_LSB[row];
+            msb[row] = LEFT_MSB[row] ^ RIGHT_MSB[row];
+        }
+        return;
+    case ONETWOEIGHTEXPR_NEGATE:
+        for (row = 0; row < ROWS; ++row) {
+            msb[row] = -LEFT_MSB[row] - (LEFT_LSB[row] != 0);
+            lsb[row] = -LEFT_LSB[row];
+        }
+        return;
+    case ONETWOEIGHTEXPR_NOT:
+        for (row = 0; row < ROWS; ++row) {
+            lsb[row] = ~LEFT_LSB[row];
+            msb[row] = ~LEFT_MSB[row];
+        }
+        return;
+    default:
+        break;
+    }
+    // Multiplication, division and shifts go row by row through the library, skipping rows that are already null
+    for (row = 0; row < ROWS; ++row) {
+        OneTwoEight result = ONETWOEIGHT_ZERO;
+    
+        if (valid[row]) {
+            valid[row] = OneTwoEightExpr_apply(OPCODE, (OneTwoEight){LEFT_LSB[row], LEFT_MSB[row]}, (OneTwoEight){RIGHT_LSB[row], RIGHT_MSB[row]}, &result);
+        }
+        lsb[row] = result.lsb;
+        msb[row] = result.msb;
+    }
+}
+
+static int OneTwoEightExpr_evaluatePartition(void *partition) {
+    const OneTwoEightExprPartition *PARTITION = partition;
+    const OneTwoEightExpr *EXPR = PARTITION->EXPR;
+    const OneTwoEightColumn *COLUMNS = PARTITION->COLUMNS, *OUTPUT = PARTITION->OUTPUT;
+    const OneTwoEightExprInstruction *instruction;
+    size_t scratchSize = (size_t)(EXPR->registerCount + EXPR->constantCount) * 2 * ONETWOEIGHTEXPR_BLOCK * sizeof(OneTwoEight_t), start, rows, row;
+    OneTwoEight_t *scratch = NULL, *resultLSB, *resultMSB;
+    bool valid[ONETWOEIGHTEXPR_BLOCK];
+    int index;
+    
+    // Each thread has its own registers, followed by the constants repeated across a block
+    // A formula that is a bare column needs neither, and malloc(0) may return NULL
+    if (scratchSize && !(scratch = malloc(scratchSize))) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (index = 0; index < EXPR->constantCount; ++index) {
+        resultLSB = OneTwoEightExpr_half(EXPR, (OneTwoEightExprOperand){ONETWOEIGHTEXPR_CONSTANT, index}, false, COLUMNS, scratch, 0);
+        resultMSB = OneTwoEightExpr_half(EXPR, (OneTwoEightExprOperand){ONETWOEIGHTEXPR_CONSTANT, index}, true, COLUMNS, scratch, 0);
+        for (row = 0; row < ONETWOEIGHTEXPR_BLOCK; ++row) {
+            resultLSB[row] = EXPR->constants[index].lsb;
+            resultMSB[row] = EXPR->constants[index].msb;
+        }
+    }
+    
+    for (start = PARTITION->first; start < PARTITION->last; start += rows) {
+        rows = ((PARTITION->last - start) < ONETWOEIGHTEXPR_BLOCK) ? (PARTITION->last - start) : ONETWOEIGHTEXPR_BLOCK;
+    
+        // A row is null if any column the formula reads is null there
+        memset(valid, true, sizeof(valid));
+        for (index = 0; index < EXPR->columnCount; ++index) {
+            if (EXPR->columnsRead[index] && COLUMNS[index].valid) {
+                for (row = 0; row < rows; ++row) {
+                    valid[row] &= COLUMNS[index].valid[start + row];
+                }
+            }
+        }
+    
+        for (instruction = EXPR->instructions; instruction < EXPR->instructions + EXPR->instructionCount; ++instruction) {
+            OneTwoEightExpr_run(instruction->opcode,
+                OneTwoEightExpr_half(EXPR, (OneTwoEightExprOperand){ONETWOEIGHTEXPR_REGISTER, instruction->destination}, false, COLUMNS, scratch, start),
+                OneTwoEightExpr_half(EXPR, (OneTwoEightExprOperand){ONETWOEIGHTEXPR_REGISTER, instruction->destination}, true, COLUMNS, scratch, start),
+                OneTwoEightExpr_half(EXPR, instruction->left, false, COLUMNS, scratch, start), OneTwoEightExpr_half(EXPR, instruction->left, true, COLUMNS, scratch, start),
+                OneTwoEightExpr_half(EXPR, instruction->right, false, COLUMNS, scratch, start), OneTwoEightExpr_half(EXPR, instruction->right, true, COLUMNS, scratch, start),
+                valid, rows);
+        }
+    
+        resultLSB = OneTwoEightExpr_half(EXPR, EXPR->result, false, COLUMNS, scratch, start);
+        resultMSB = OneTwoEightExpr_half(EXPR, EXPR->result, true, COLUMNS, scratch, start);
+        for (row = 0; row < rows; ++row) {
+            OUTPUT->lsb[start + row] = valid[row] ? resultLSB[row] : 0;
+            OUTPUT->msb[start + row] = valid[row] ? resultMSB[row] : 0;
+        }
+        if (OUTPUT->valid) {
+            memcpy(OUTPUT->valid + start, valid, rows * sizeof(bool));
+        }
+    }
+    free(scratch);
+    return 0;
+}
+
+OneTwoEightExpr *OneTwoEightExpr_compile(const char *TEXT, const char *const *NAMES, const int NAME_COUNT) {
+    OneTwoEightExprParser parser = {TEXT, NAMES, NAME_COUNT, 0, NULL, NULL};
+    OneTwoEightExpr *expr;
+    bool *registersBusy;
+    int root;
+    
+    if (!(parser.nodes = malloc((strlen(TEXT) + 1) * sizeof(OneTwoEightExprNode)))) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    root = OneTwoEightExpr_parseBinary(&parser, 0);
+    OneTwoEightExpr_skipSpace(&parser);
+    if (!parser.error && *parser.cursor) {
+        OneTwoEightExpr_fail(&parser, "expected an operator");
+    }
+    if (parser.error) {
+        fprintf(stderr, "Expression error at offset %d: %s.\n", (int)(parser.cursor - TEXT), parser.error);
+        free(parser.nodes);
+        return NULL;
+    }
+    
+    // Nodes bound the number of instructions, constants and registers alike
+    expr = calloc(1, sizeof(OneTwoEightExpr));
+    registersBusy = calloc(parser.nodeCount, sizeof(bool));
+    if (!expr || !registersBusy || !(expr->instructions = malloc(parser.nodeCount * sizeof(OneTwoEightExprInstruction)))
+        || !(expr->constants = malloc(parser.nodeCount * sizeof(OneTwoEight))) || !(expr->columnsRead = calloc(NAME_COUNT + 1, sizeof(bool)))) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    expr->columnCount = NAME_COUNT;
+    expr->result = OneTwoEightExpr_emit(expr, parser.nodes, root, registersBusy);
+    free(registersBusy);
+    free(parser.nodes);
+    return expr;
+}
+
+void OneTwoEightExpr_destroy(OneTwoEightExpr *expr) {
+    free(expr->instructions);
+    free(expr->constants);
+    free(expr->columnsRead);
+    free(expr);
+}
+
+void OneTwoEightExpr_evaluate(const OneTwoEightExpr *EXPR, const OneTwoEightColumn *COLUMNS, const OneTwoEightColumn *OUTPUT, const size_t ROWS, const int THREADS) {
+    size_t blocks = (ROWS + ONETWOEIGHTEXPR_BLOCK - 1) / ONETWOEIGHTEXPR_BLOCK, threadCount, thread;
+    OneTwoEightExprPartition *partitions;
+    bool *started;
+#ifdef ONETWOEIGHT_HAS_THREADS
+    thrd_t *threads;
+#endif // ONETWOEIGHT_HAS_THREADS
+    
+    if (!blocks) {
+        return;
+    }
+    threadCount = (THREADS < 1) ? 1 : (((size_t)(THREADS) > blocks) ? blocks : (size_t)(THREADS));
+    partitions = malloc(threadCount * sizeof(OneTwoEightExprPartition));
+    started = calloc(threadCount, sizeof(bool));
+#ifdef ONETWOEIGHT_HAS_THREADS
+    if (!(threads = malloc(threadCount * sizeof(thrd_t)))) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+#endif // ONETWOEIGHT_HAS_THREADS
+    if (!partitions || !started) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    // Whole blocks, spread as evenly as possible; rows of one block never straddle two threads
+    for (thread = 0; thread < threadCount; ++thread) {
+        partitions[thread] = (OneTwoEightExprPartition){EXPR, COLUMNS, OUTPUT, blocks * thread / threadCount * ONETWOEIGHTEXPR_BLOCK, blocks * (thread + 1) / threadCount * ONETWOEIGHTEXPR_BLOCK};
+        partitions[thread].last = (partitions[thread].last > ROWS) ? ROWS : partitions[thread].last;
+    }
+    // The calling thread takes the first partition itself, and any whose thread could not start; without C11 threads, all of them
+#ifdef ONETWOEIGHT_HAS_THREADS
+    for (thread = 1; thread < threadCount; ++thread) {
+        started[thread] = thrd_create(&threads[thread], OneTwoEightExpr_evaluatePartition, &partitions[thread]) == thrd_success;
+    }
+#endif // ONETWOEIGHT_HAS_THREADS
+    OneTwoEightExpr_evaluatePartition(&partitions[0]);
+    for (thread = 1; thread < threadCount; ++thread) {
+#ifdef ONETWOEIGHT_HAS_THREADS
+        if (started[thread]) {
+            thrd_join(threads[thread], NULL);
+            continue;
+        }
+#endif // ONETWOEIGHT_HAS_THREADS
+        OneTwoEightExpr_evaluatePartition(&partitions[thread]);
+    }
+    free(partitions);
+    free(started);
+#ifdef ONETWOEIGHT_HAS_THREADS
+    free(threads);
+#endif // ONETWOEIGHT_HAS_THREADS
+}
+
+static void OneTwoEightExpr_printOperand(const OneTwoEightExpr *EXPR, const OneTwoEightExprOperand OPERAND) {
+    switch (OPERAND.source) {
+    case ONETWOEIGHTEXPR_REGISTER:
+        printf("r%d", OPERAND.index);
+        break;
+    case ONETWOEIGHTEXPR_COLUMN:
+        printf("c%d", OPERAND.index);
+        break;
+    case ONETWOEIGHTEXPR_CONSTANT:
+        // Written back as a literal the parser accepts
+        if (EXPR->constants[OPERAND.index].msb) {
+            printf("0x%" PRIx64 "%016" PRIx64, EXPR->constants[OPERAND.index].msb, EXPR->constants[OPERAND.index].lsb);
+        }
+        else {
+            printf("%" PRIu64, EXPR->constants[OPERAND.index].lsb);
+        }
+    }
+}
+
+void OneTwoEightExpr_print(const OneTwoEightExpr *EXPR) {
+    static const char *const MNEMONICS[] = {"add", "sub", "mul", "div", "mod", "and", "or", "xor", "shl", "shr", "neg", "not"};
+    int index;
+    
+    for (index = 0; index < EXPR->instructionCount; ++index) {
+        printf("r%d = %s ", EXPR->instructions[index].destination, MNEMONICS[EXPR->instructions[index].opcode]);
+        OneTwoEightExpr_printOperand(EXPR, EXPR->instructions[index].left);
+        // Unary opcodes come last
+        if (EXPR->instructions[index].opcode < ONETWOEIGHTEXPR_NEGATE) {
+            printf(", ");
+            OneTwoEightExpr_printOperand(EXPR, EXPR->instructions[index].right);
+        }
+        puts("");
+    }
+    printf("return ");
+    OneTwoEightExpr_printOperand(EXPR, EXPR->result);
+    puts("");
+}
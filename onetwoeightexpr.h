@@ -0,0 +1,63 @@
+/*
+    Copyright (C) 2022 TheTrustedComputer
+*/
+
+#ifndef ONETWOEIGHTEXPR_H
+#define ONETWOEIGHTEXPR_H
+
+#include "onetwoeight.h"
+
+/*
+    Formulas over 128-bit columns, such as "(a * b + c) % d >> 3", compiled to register bytecode and run a block of rows at a time.
+    The operators are the unsigned ones of the library with C precedence: unary - ~ +, then * / %, + -, << >>, &, ^ and |.
+    Literals are decimal or 0x-prefixed hexadecimal. Subexpressions made only of literals are folded while compiling.
+    Each instruction sweeps a whole block before the next one starts, so the dispatch cost is paid once per block rather than once per row.
+    A row is null when any column it reads is null there, or when it divides by zero.
+*/
+#define ONETWOEIGHTEXPR_BLOCK 1024 // Rows each instruction runs over at a time
+
+// Structure of arrays: the halves of each row live in separate arrays, so whole blocks of them load as vectors
+typedef struct OneTwoEightColumn {
+    OneTwoEight_t *lsb, *msb;
+    bool *valid; // One flag per row; NULL means no row is null
+} OneTwoEightColumn;
+
+typedef enum OneTwoEightExprOpcode {
+    ONETWOEIGHTEXPR_ADD, ONETWOEIGHTEXPR_SUBTRACT, ONETWOEIGHTEXPR_MULTIPLY, ONETWOEIGHTEXPR_DIVIDE, ONETWOEIGHTEXPR_MODULUS,
+    ONETWOEIGHTEXPR_AND, ONETWOEIGHTEXPR_OR, ONETWOEIGHTEXPR_XOR, ONETWOEIGHTEXPR_LEFT_SHIFT, ONETWOEIGHTEXPR_RIGHT_SHIFT,
+    ONETWOEIGHTEXPR_NEGATE, ONETWOEIGHTEXPR_NOT
+} OneTwoEightExprOpcode;
+
+typedef enum OneTwoEightExprSource {
+    ONETWOEIGHTEXPR_REGISTER, ONETWOEIGHTEXPR_COLUMN, ONETWOEIGHTEXPR_CONSTANT
+} OneTwoEightExprSource;
+
+typedef struct OneTwoEightExprOperand {
+    OneTwoEightExprSource source;
+    int index;
+} OneTwoEightExprOperand;
+
+typedef struct OneTwoEightExprInstruction {
+    OneTwoEightExprOpcode opcode;
+    int destination; // Always a register
+    OneTwoEightExprOperand left, right; // Unary instructions ignore the right operand
+} OneTwoEightExprInstruction;
+
+typedef struct OneTwoEightExpr {
+    OneTwoEightExprInstruction *instructions;
+    OneTwoEight *constants;
+    bool *columnsRead; // Which columns can make a row null
+    int instructionCount, constantCount, registerCount, columnCount;
+    OneTwoEightExprOperand result;
+} OneTwoEightExpr;
+
+// Compiles a formula whose identifiers name the columns in order; NULL with a message on stderr when it does not parse
+OneTwoEightExpr *OneTwoEightExpr_compile(const char*, const char *const*, const int);
+void OneTwoEightExpr_destroy(OneTwoEightExpr*);
+// Evaluates rows of the columns into the output, splitting them across threads; null rows come out as zero, and invalid if the output has flags
+// Threads are C11 ones, used when the includer found <threads.h> and defined ONETWOEIGHT_HAS_THREADS as main.c does; otherwise the calling thread runs every part
+void OneTwoEightExpr_evaluate(const OneTwoEightExpr*, const OneTwoEightColumn*, const OneTwoEightColumn*, const size_t, const int);
+// Lists the bytecode
+void OneTwoEightExpr_print(const OneTwoEightExpr*);
+
+#endif // ONETWOEIGHTEXPR_H
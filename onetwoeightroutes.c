@@ -0,0 +1,325 @@
+/*
+    Copyright (C) 2022 TheTrustedComputer
+*/
+
+#include "onetwoeightroutes.h"
+
+#define ONETWOEIGHTROUTES_LENGTH_SHIFT 22
+#define ONETWOEIGHTROUTES_VALID 0x40000000u
+#define ONETWOEIGHTROUTES_GROUP 0x80000000u
+#define ONETWOEIGHTROUTES_TOP_LEVEL UINT32_MAX // Group index standing for the top table
+#define ONETWOEIGHTROUTES_BATCH 16 // Lookups kept in flight at once by the batched lookup
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ONETWOEIGHTROUTES_PREFETCH(ADDRESS) __builtin_prefetch(ADDRESS)
+#else
+#define ONETWOEIGHTROUTES_PREFETCH(ADDRESS)
+#endif // __GNUC__
+
+// Decides which entries covered by a prefix an insertion or removal rewrites
+typedef struct OneTwoEightRoutesUpdate {
+    OneTwoEightRoutesEntry replacement;
+    int length; // Inserting overwrites entries from prefixes up to this long; removing, only those exactly this long
+    bool inserting;
+} OneTwoEightRoutesUpdate;
+
+OneTwoEight OneTwoEight_prefixMask(const int LENGTH) {
+    // Shifting all ones right by the length leaves exactly the host bits; shifting by 128 already yields zero
+    return OneTwoEight_bitwiseNot(OneTwoEight_rightShift(ONETWOEIGHT_UMAX, LENGTH));
+}
+
+OneTwoEight OneTwoEight_prefixNetwork(const OneTwoEight ADDRESS, const int LENGTH) {
+    return OneTwoEight_bitwiseAnd(ADDRESS, OneTwoEight_prefixMask(LENGTH));
+}
+
+OneTwoEight OneTwoEight_prefixBroadcast(const OneTwoEight ADDRESS, const int LENGTH) {
+    return OneTwoEight_bitwiseOr(ADDRESS, OneTwoEight_bitwiseNot(OneTwoEight_prefixMask(LENGTH)));
+}
+
+bool OneTwoEight_prefixContains(const OneTwoEight PREFIX, const int LENGTH, const OneTwoEight ADDRESS) {
+    return OneTwoEight_equal(OneTwoEight_prefixNetwork(PREFIX, LENGTH), OneTwoEight_prefixNetwork(ADDRESS, LENGTH));
+}
+
+static OneTwoEightRoutesEntry OneTwoEightRoutes_leaf(const uint32_t NEXT_HOP, const int LENGTH) {
+    return NEXT_HOP | ((OneTwoEightRoutesEntry)(LENGTH) << ONETWOEIGHTROUTES_LENGTH_SHIFT) | ONETWOEIGHTROUTES_VALID;
+}
+
+static int OneTwoEightRoutes_entryLength(const OneTwoEightRoutesEntry ENTRY) {
+    return (ENTRY >> ONETWOEIGHTROUTES_LENGTH_SHIFT) & 0xff;
+}
+
+// Byte of the address counted from the most significant one, which indexes the group at that depth
+static unsigned OneTwoEightRoutes_byte(const OneTwoEight ADDRESS, const int INDEX) {
+    return ((INDEX < 8) ? (ADDRESS.msb >> (56 - 8 * INDEX)) : (ADDRESS.lsb >> (120 - 8 * INDEX))) & 0xff;
+}
+
+static OneTwoEightRoutesEntry *OneTwoEightRoutes_entries(OneTwoEightRoutes *routes, const uint32_t GROUP) {
+    return (GROUP == ONETWOEIGHTROUTES_TOP_LEVEL) ? routes->top : routes->groups[GROUP];
+}
+
+static size_t OneTwoEightRoutes_hash(const OneTwoEight PREFIX, const int LENGTH) {
+    // SplitMix64 finalizer over the folded key
+    uint64_t hash = PREFIX.msb ^ (PREFIX.lsb * 0x9e3779b97f4a7c15ull) ^ (uint64_t)(LENGTH);
+    
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return (size_t)(hash ^ (hash >> 31));
+}
+
+// Slot holding the rule, or the free slot it would go in
+static size_t OneTwoEightRoutes_findRule(const OneTwoEightRoutes *ROUTES, const OneTwoEight PREFIX, const int LENGTH) {
+    size_t mask = ROUTES->ruleCapacity - 1, slot;
+    
+    for (slot = OneTwoEightRoutes_hash(PREFIX, LENGTH) & mask; ROUTES->rules[slot].used; slot = (slot + 1) & mask) {
+        if ((ROUTES->rules[slot].length == LENGTH) && OneTwoEight_equal(ROUTES->rules[slot].prefix, PREFIX)) {
+            break;
+        }
+    }
+    return slot;
+}
+
+static void OneTwoEightRoutes_growRules(OneTwoEightRoutes *routes) {
+    OneTwoEightRoutesRule *old = routes->rules;
+    size_t oldCapacity = routes->ruleCapacity, slot;
+    
+    routes->ruleCapacity *= 2;
+    if (!(routes->rules = calloc(routes->ruleCapacity, sizeof(OneTwoEightRoutesRule)))) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (slot = 0; slot < oldCapacity; ++slot) {
+        if (old[slot].used) {
+            routes->rules[OneTwoEightRoutes_findRule(routes, old[slot].prefix, old[slot].length)] = old[slot];
+        }
+    }
+    free(old);
+}
+
+static void OneTwoEightRoutes_eraseRule(OneTwoEightRoutes *routes, size_t slot) {
+    size_t mask = routes->ruleCapacity - 1, next, home;
+    
+    // Backward shift deletion: pull later rules of the same probe run into the hole, so lookups never need tombstones
+    routes->rules[slot].used = false;
+    for (next = (slot + 1) & mask; routes->rules[next].used; next = (next + 1) & mask) {
+        home = OneTwoEightRoutes_hash(routes->rules[next].prefix, routes->rules[next].length) & mask;
+        // The rule may move back only if the hole lies between its home slot and where it sits now
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            routes->rules[slot] = routes->rules[next];
+            routes->rules[next].used = false;
+            slot = next;
+        }
+    }
+    --routes->ruleCount;
+}
+
+static uint32_t OneTwoEightRoutes_allocateGroup(OneTwoEightRoutes *routes, const OneTwoEightRoutesEntry FILL) {
+    uint32_t group;
+    int entry;
+    
+    if (routes->freeGroups != ONETWOEIGHTROUTES_TOP_LEVEL) {
+        group = routes->freeGroups;
+        routes->freeGroups = routes->groups[group][0];
+    }
+    else {
+        if (routes->groupCount == routes->groupCapacity) {
+            // Group indexes share an entry with the flags, just like next hops
+            if (routes->groupCapacity > ONETWOEIGHTROUTES_NEXT_HOP_MAX / 2) {
+                fprintf(stderr, "Route table is full.\n");
+                exit(EXIT_FAILURE);
+            }
+            routes->groupCapacity = routes->groupCapacity ? (routes->groupCapacity * 2) : 256;
+            if (!(routes->groups = realloc(routes->groups, routes->groupCapacity * sizeof(routes->groups[0])))) {
+                fprintf(stderr, "Out of memory.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        group = routes->groupCount++;
+    }
+    // A new group starts out inheriting the entry it replaces
+    for (entry = 0; entry < 256; ++entry) {
+        routes->groups[group][entry] = FILL;
+    }
+    ++routes->groupsInUse;
+    return group;
+}
+
+// Folds a group back into the entry pointing at it once all of its entries agree
+static void OneTwoEightRoutes_collapse(OneTwoEightRoutes *routes, OneTwoEightRoutesEntry *entry) {
+    OneTwoEightRoutesEntry first;
+    uint32_t group;
+    int index;
+    
+    if (!(*entry & ONETWOEIGHTROUTES_GROUP)) {
+        return;
+    }
+    group = *entry & ONETWOEIGHTROUTES_NEXT_HOP_MAX;
+    first = routes->groups[group][0];
+    if (first & ONETWOEIGHTROUTES_GROUP) {
+        return;
+    }
+    for (index = 1; (index < 256) && (routes->groups[group][index] == first); ++index);
+    if (index == 256) {
+        *entry = first;
+        routes->groups[group][0] = routes->freeGroups;
+        routes->freeGroups = group;
+        --routes->groupsInUse;
+    }
+}
+
+static void OneTwoEightRoutes_paint(OneTwoEightRoutes *routes, OneTwoEightRoutesEntry *entry, const OneTwoEightRoutesUpdate *UPDATE) {
+    uint32_t group;
+    int index;
+    
+    // A prefix covering a whole group covers every entry in it, however deep
+    if (*entry & ONETWOEIGHTROUTES_GROUP) {
+        group = *entry & ONETWOEIGHTROUTES_NEXT_HOP_MAX;
+        for (index = 0; index < 256; ++index) {
+            OneTwoEightRoutes_paint(routes, &routes->groups[group][index], UPDATE);
+        }
+        OneTwoEightRoutes_collapse(routes, entry);
+    }
+    else if (UPDATE->inserting ? (!(*entry & ONETWOEIGHTROUTES_VALID) || (OneTwoEightRoutes_entryLength(*entry) <= UPDATE->length))
+                               : ((*entry & ONETWOEIGHTROUTES_VALID) && (OneTwoEightRoutes_entryLength(*entry) == UPDATE->length))) {
+        *entry = UPDATE->replacement;
+    }
+}
+
+// Walks down to the level the prefix ends in, expanding entries into groups on the way, then rewrites the entries it covers
+static void OneTwoEightRoutes_update(OneTwoEightRoutes *routes, const uint32_t GROUP, const int START, const OneTwoEight PREFIX, const int LENGTH, const OneTwoEightRoutesUpdate *UPDATE) {
+    int width = (GROUP == ONETWOEIGHTROUTES_TOP_LEVEL) ? ONETWOEIGHTROUTES_TOP_BITS : 8;
+    unsigned index = (GROUP == ONETWOEIGHTROUTES_TOP_LEVEL) ? (unsigned)(PREFIX.msb >> (64 - ONETWOEIGHTROUTES_TOP_BITS)) : OneTwoEightRoutes_byte(PREFIX, START / 8);
+    unsigned covered;
+    uint32_t child;
+    
+    if (LENGTH <= START + width) {
+        // The host bits are clear, so the prefix covers an aligned run starting at index
+        for (covered = 0; covered < (1u << (START + width - LENGTH)); ++covered) {
+            OneTwoEightRoutes_paint(routes, &OneTwoEightRoutes_entries(routes, GROUP)[index + covered], UPDATE);
+        }
+        return;
+    }
+    if (!(OneTwoEightRoutes_entries(routes, GROUP)[index] & ONETWOEIGHTROUTES_GROUP)) {
+        // Allocating may move every group, so look the entry up again afterwards
+        child = OneTwoEightRoutes_allocateGroup(routes, OneTwoEightRoutes_entries(routes, GROUP)[index]);
+        OneTwoEightRoutes_entries(routes, GROUP)[index] = child | ONETWOEIGHTROUTES_GROUP;
+    }
+    OneTwoEightRoutes_update(routes, OneTwoEightRoutes_entries(routes, GROUP)[index] & ONETWOEIGHTROUTES_NEXT_HOP_MAX, START + width, PREFIX, LENGTH, UPDATE);
+    OneTwoEightRoutes_collapse(routes, &OneTwoEightRoutes_entries(routes, GROUP)[index]);
+}
+
+static void OneTwoEightRoutes_checkLength(const int LENGTH) {
+    if ((LENGTH < 0) || (LENGTH > 128)) {
+        fprintf(stderr, "Prefix length %d is out of range.\n", LENGTH);
+        exit(EXIT_FAILURE);
+    }
+}
+
+OneTwoEightRoutes *OneTwoEightRoutes_create(void) {
+    OneTwoEightRoutes *routes;
+    
+    // An all-zero top table has no valid entries
+    if (!(routes = calloc(1, sizeof(OneTwoEightRoutes))) || !(routes->rules = calloc(1024, sizeof(OneTwoEightRoutesRule)))) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    routes->ruleCapacity = 1024;
+    routes->freeGroups = ONETWOEIGHTROUTES_TOP_LEVEL;
+    return routes;
+}
+
+void OneTwoEightRoutes_destroy(OneTwoEightRoutes *routes) {
+    free(routes->groups);
+    free(routes->rules);
+    free(routes);
+}
+
+void OneTwoEightRoutes_insert(OneTwoEightRoutes *routes, const OneTwoEight PREFIX, const int LENGTH, const uint32_t NEXT_HOP) {
+    OneTwoEightRoutesUpdate update = {OneTwoEightRoutes_leaf(NEXT_HOP, LENGTH), LENGTH, true};
+    OneTwoEight network;
+    size_t slot;
+    
+    OneTwoEightRoutes_checkLength(LENGTH);
+    if (NEXT_HOP > ONETWOEIGHTROUTES_NEXT_HOP_MAX) {
+        fprintf(stderr, "Next hop %" PRIu32 " is out of range.\n", NEXT_HOP);
+        exit(EXIT_FAILURE);
+    }
+    network = OneTwoEight_prefixNetwork(PREFIX, LENGTH);
+    
+    // Keep the table at most half full
+    if ((routes->ruleCount + 1) * 2 > routes->ruleCapacity) {
+        OneTwoEightRoutes_growRules(routes);
+    }
+    slot = OneTwoEightRoutes_findRule(routes, network, LENGTH);
+    if (!routes->rules[slot].used) {
+        routes->rules[slot] = (OneTwoEightRoutesRule){network, NEXT_HOP, (uint8_t)(LENGTH), true};
+        ++routes->ruleCount;
+    }
+    routes->rules[slot].nextHop = NEXT_HOP;
+    OneTwoEightRoutes_update(routes, ONETWOEIGHTROUTES_TOP_LEVEL, 0, network, LENGTH, &update);
+}
+
+bool OneTwoEightRoutes_remove(OneTwoEightRoutes *routes, const OneTwoEight PREFIX, const int LENGTH) {
+    OneTwoEightRoutesUpdate update = {0, LENGTH, false}; // No replacement leaves the entries invalid
+    OneTwoEight network;
+    size_t slot;
+    int length;
+    
+    OneTwoEightRoutes_checkLength(LENGTH);
+    network = OneTwoEight_prefixNetwork(PREFIX, LENGTH);
+    slot = OneTwoEightRoutes_findRule(routes, network, LENGTH);
+    if (!routes->rules[slot].used) {
+        return false;
+    }
+    OneTwoEightRoutes_eraseRule(routes, slot);
+    
+    // Entries the prefix wrote fall back to the longest remaining prefix covering it
+    for (length = LENGTH - 1; length >= 0; --length) {
+        slot = OneTwoEightRoutes_findRule(routes, OneTwoEight_prefixNetwork(network, length), length);
+        if (routes->rules[slot].used) {
+            update.replacement = OneTwoEightRoutes_leaf(routes->rules[slot].nextHop, length);
+            break;
+        }
+    }
+    OneTwoEightRoutes_update(routes, ONETWOEIGHTROUTES_TOP_LEVEL, 0, network, LENGTH, &update);
+    return true;
+}
+
+uint32_t OneTwoEightRoutes_lookup(const OneTwoEightRoutes *ROUTES, const OneTwoEight ADDRESS) {
+    OneTwoEightRoutesEntry entry = ROUTES->top[ADDRESS.msb >> (64 - ONETWOEIGHTROUTES_TOP_BITS)];
+    int index;
+    
+    for (index = ONETWOEIGHTROUTES_TOP_BITS / 8; entry & ONETWOEIGHTROUTES_GROUP; ++index) {
+        entry = ROUTES->groups[entry & ONETWOEIGHTROUTES_NEXT_HOP_MAX][OneTwoEightRoutes_byte(ADDRESS, index)];
+    }
+    return (entry & ONETWOEIGHTROUTES_VALID) ? (entry & ONETWOEIGHTROUTES_NEXT_HOP_MAX) : ONETWOEIGHTROUTES_NONE;
+}
+
+void OneTwoEightRoutes_lookupBatch(const OneTwoEightRoutes *ROUTES, const OneTwoEight *ADDRESSES, uint32_t *nextHops, const size_t COUNT) {
+    const OneTwoEightRoutesEntry *pending[ONETWOEIGHTROUTES_BATCH];
+    size_t base, lookup, batch;
+    int index;
+    bool descending;
+    
+    // Advance a batch of lookups one level at a time, prefetching every next entry before reading any of them,
+    // so their cache misses overlap instead of running back to back
+    for (base = 0; base < COUNT; base += batch) {
+        batch = ((COUNT - base) < ONETWOEIGHTROUTES_BATCH) ? (COUNT - base) : ONETWOEIGHTROUTES_BATCH;
+        for (lookup = 0; lookup < batch; ++lookup) {
+            pending[lookup] = &ROUTES->top[ADDRESSES[base + lookup].msb >> (64 - ONETWOEIGHTROUTES_TOP_BITS)];
+            ONETWOEIGHTROUTES_PREFETCH(pending[lookup]);
+        }
+        for (index = ONETWOEIGHTROUTES_TOP_BITS / 8, descending = true; descending; ++index) {
+            descending = false;
+            for (lookup = 0; lookup < batch; ++lookup) {
+                if (*pending[lookup] & ONETWOEIGHTROUTES_GROUP) {
+                    pending[lookup] = &ROUTES->groups[*pending[lookup] & ONETWOEIGHTROUTES_NEXT_HOP_MAX][OneTwoEightRoutes_byte(ADDRESSES[base + lookup], index)];
+                    ONETWOEIGHTROUTES_PREFETCH(pending[lookup]);
+                    descending = true;
+                }
+            }
+        }
+        for (lookup = 0; lookup < batch; ++lookup) {
+            nextHops[base + lookup] = (*pending[lookup] & ONETWOEIGHTROUTES_VALID) ? (*pending[lookup] & ONETWOEIGHTROUTES_NEXT_HOP_MAX) : ONETWOEIGHTROUTES_NONE;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+/*
+    Copyright (C) 2022 TheTrustedComputer
+*/
+
+#ifndef ONETWOEIGHTROUTES_H
+#define ONETWOEIGHTROUTES_H
+
+#include "onetwoeight.h"
+
+/* CIDR prefixes of 128-bit addresses such as IPv6, with lengths from 0 to 128 */
+OneTwoEight OneTwoEight_prefixMask(const int); // The leading LENGTH bits set
+OneTwoEight OneTwoEight_prefixNetwork(const OneTwoEight, const int); // First address of the prefix
+OneTwoEight OneTwoEight_prefixBroadcast(const OneTwoEight, const int); // Last address of the prefix
+bool OneTwoEight_prefixContains(const OneTwoEight, const int, const OneTwoEight); // Whether the address lies within the prefix
+
+/*
+    Longest prefix match table mapping prefixes to next hops, DIR-16-8-...-8 style:
+    the first 16 address bits index one flat table, and every further byte indexes a 256-entry group, allocated only where a longer prefix needs it.
+    Shorter prefixes are expanded into every entry they cover, so a lookup is one memory access per level with no backtracking.
+    Every entry also remembers the length of the prefix that wrote it, so inserting or removing a prefix only rewrites the entries it covers.
+*/
+#define ONETWOEIGHTROUTES_NONE UINT32_MAX // Lookup result when no prefix matches
+#define ONETWOEIGHTROUTES_NEXT_HOP_MAX 0x3fffffu // Next hops share their 32-bit entry with the prefix length and flags
+#define ONETWOEIGHTROUTES_TOP_BITS 16
+
+typedef uint32_t OneTwoEightRoutesEntry; // Next hop or group index : 22, prefix length : 8, valid : 1, group : 1
+
+typedef struct OneTwoEightRoutesRule {
+    OneTwoEight prefix;
+    uint32_t nextHop;
+    uint8_t length;
+    bool used;
+} OneTwoEightRoutesRule;
+
+typedef struct OneTwoEightRoutes {
+    OneTwoEightRoutesEntry top[1 << ONETWOEIGHTROUTES_TOP_BITS];
+    OneTwoEightRoutesEntry (*groups)[256];
+    uint32_t groupCount, groupCapacity, groupsInUse;
+    uint32_t freeGroups; // Freed groups are chained through their first entry
+    OneTwoEightRoutesRule *rules; // Open addressing by prefix and length, so removal can find the next shorter covering prefix
+    size_t ruleCount, ruleCapacity;
+} OneTwoEightRoutes;
+
+// Lifetime
+OneTwoEightRoutes *OneTwoEightRoutes_create(void);
+void OneTwoEightRoutes_destroy(OneTwoEightRoutes*);
+// Updates; host bits of the prefix are ignored
+void OneTwoEightRoutes_insert(OneTwoEightRoutes*, const OneTwoEight, const int, const uint32_t); // Adds the prefix, or replaces its next hop
+bool OneTwoEightRoutes_remove(OneTwoEightRoutes*, const OneTwoEight, const int); // False when the prefix is not in the table
+// Lookups
+uint32_t OneTwoEightRoutes_lookup(const OneTwoEightRoutes*, const OneTwoEight); // Next hop of the longest matching prefix
+void OneTwoEightRoutes_lookupBatch(const OneTwoEightRoutes*, const OneTwoEight*, uint32_t*, const size_t); // Interleaves lookups to overlap their cache misses
+
+#endif // ONETWOEIGHTROUTES_H
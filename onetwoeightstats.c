@@ -0,0 +1,144 @@
+/*
+    Copyright (C) 2022 TheTrustedComputer
+*/
+
+#include "onetwoeightstats.h"
+
+static const OneTwoEightStatsSummary ONETWOEIGHTSTATS_EMPTY = (OneTwoEightStatsSummary){{0x0ull, 0x0ull}, {0x0ull, 0x0ull}, 0, UINT64_MAX, 0};
+
+static OneTwoEightStatsSummary OneTwoEightStats_combine(OneTwoEightStatsSummary left, const OneTwoEightStatsSummary RIGHT) {
+    OneTwoEight_addAssign(&left.sum, RIGHT.sum);
+    OneTwoEight_addAssign(&left.sumSquares, RIGHT.sumSquares);
+    left.count += RIGHT.count;
+    left.min = (RIGHT.min < left.min) ? RIGHT.min : left.min;
+    left.max = (RIGHT.max > left.max) ? RIGHT.max : left.max;
+    return left;
+}
+
+static OneTwoEightStatsSummary OneTwoEightStats_read(OneTwoEightStatsShard *shard) {
+    OneTwoEightStatsSummary copy;
+    unsigned before, after;
+    
+    // Sequence lock: copy, then check the writer neither was in the middle of nor finished an update meanwhile
+    do {
+        before = atomic_load_explicit(&shard->sequence, memory_order_acquire);
+        copy = shard->summary;
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&shard->sequence, memory_order_relaxed);
+    } while ((before & 1) || (before != after));
+    return copy;
+}
+
+static void OneTwoEightStats_write(OneTwoEightStatsShard *shard, const OneTwoEightStatsSummary SUMMARY) {
+    // Only one thread ever writes a shard, so plain stores of the sequence suffice
+    unsigned sequence = atomic_load_explicit(&shard->sequence, memory_order_relaxed);
+    
+    atomic_store_explicit(&shard->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    shard->summary = SUMMARY;
+    atomic_store_explicit(&shard->sequence, sequence + 2, memory_order_release);
+}
+
+OneTwoEightStats *OneTwoEightStats_create(const unsigned SHARDS) {
+    OneTwoEightStats *stats;
+    unsigned shard;
+    
+    if (!SHARDS) {
+        fprintf(stderr, "Statistics need at least one shard.\n");
+        exit(EXIT_FAILURE);
+    }
+    // Both sizes are multiples of the 64-byte alignment, as aligned_alloc requires
+    if (!(stats = aligned_alloc(64, sizeof(OneTwoEightStats) + SHARDS * sizeof(OneTwoEightStatsShard)))) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    atomic_init(&stats->published.sequence, 0);
+    stats->published.summary = ONETWOEIGHTSTATS_EMPTY;
+    atomic_init(&stats->shardsTaken, 0);
+    stats->shardCount = SHARDS;
+    for (shard = 0; shard < SHARDS; ++shard) {
+        atomic_init(&stats->shards[shard].sequence, 0);
+        stats->shards[shard].summary = ONETWOEIGHTSTATS_EMPTY;
+    }
+    return stats;
+}
+
+void OneTwoEightStats_destroy(OneTwoEightStats *stats) {
+    free(stats);
+}
+
+OneTwoEightStatsShard *OneTwoEightStats_acquireShard(OneTwoEightStats *stats) {
+    // The only atomic read-modify-write a writer ever does, once per thread
+    // Counting stops at shardCount, so however often writers are turned away it cannot wrap around onto a taken shard
+    unsigned shard = atomic_load_explicit(&stats->shardsTaken, memory_order_relaxed);
+    
+    do {
+        if (shard >= stats->shardCount) {
+            return NULL;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&stats->shardsTaken, &shard, shard + 1, memory_order_relaxed, memory_order_relaxed));
+    return &stats->shards[shard];
+}
+
+void OneTwoEightStats_record(OneTwoEightStatsShard *shard, const uint64_t VALUE) {
+    OneTwoEightStatsSummary summary = shard->summary; // The owner is the only writer, so it may read without retrying
+    OneTwoEight value = OneTwoEight_fromUInt64(VALUE);
+    
+    // A 64x64-bit square always fits in 128 bits
+    OneTwoEight_addAssign(&summary.sum, value);
+    OneTwoEight_addAssign(&summary.sumSquares, OneTwoEight_multiply(value, value));
+    ++summary.count;
+    summary.min = (VALUE < summary.min) ? VALUE : summary.min;
+    summary.max = (VALUE > summary.max) ? VALUE : summary.max;
+    OneTwoEightStats_write(shard, summary);
+}
+
+OneTwoEightStatsSummary OneTwoEightStats_merge(OneTwoEightStats *stats) {
+    OneTwoEightStatsSummary merged = ONETWOEIGHTSTATS_EMPTY;
+    unsigned shard;
+    
+    for (shard = 0; shard < stats->shardCount; ++shard) {
+        merged = OneTwoEightStats_combine(merged, OneTwoEightStats_read(&stats->shards[shard]));
+    }
+    return merged;
+}
+
+void OneTwoEightStats_publish(OneTwoEightStats *stats) {
+    OneTwoEightStats_write(&stats->published, OneTwoEightStats_merge(stats));
+}
+
+OneTwoEightStatsSummary OneTwoEightStats_published(OneTwoEightStats *stats) {
+    return OneTwoEightStats_read(&stats->published);
+}
+
+OneTwoEight OneTwoEightStats_mean(const OneTwoEightStatsSummary SUMMARY, OneTwoEight *REM_MEAN) {
+    // The mean of nothing is zero rather than a division by zero
+    if (!SUMMARY.count) {
+        if (REM_MEAN) {
+            *REM_MEAN = ONETWOEIGHT_ZERO;
+        }
+        return ONETWOEIGHT_ZERO;
+    }
+    return OneTwoEight_divide(SUMMARY.sum, OneTwoEight_fromUInt64(SUMMARY.count), true, REM_MEAN);
+}
+
+OneTwoEight OneTwoEightStats_variance(const OneTwoEightStatsSummary SUMMARY) {
+    OneTwoEight count, meanQuot, meanRem, spread, spreadQuot, spreadRem;
+    
+    if (!SUMMARY.count) {
+        return ONETWOEIGHT_ZERO;
+    }
+    // The textbook (n * sumSquares - sum * sum) / (n * n) needs 256 bits, so split the mean instead
+    // With sum = q * n + r, n * variance = sumSquares - q * sum - q * r - r * r / n, where every term fits in 128 bits
+    count = OneTwoEight_fromUInt64(SUMMARY.count);
+    meanQuot = OneTwoEight_divide(SUMMARY.sum, count, true, &meanRem);
+    spread = OneTwoEight_subtract(SUMMARY.sumSquares, OneTwoEight_multiply(meanQuot, SUMMARY.sum));
+    OneTwoEight_subtractAssign(&spread, OneTwoEight_multiply(meanQuot, meanRem));
+    // Dividing spread = a * n + b by n leaves the fraction (b - r * r / n) / n, which lies strictly between -1 and 1
+    // So the floor is a, or one less when b * n < r * r; both products stay below n * n < 2^128
+    spreadQuot = OneTwoEight_divide(spread, count, true, &spreadRem);
+    if (OneTwoEight_lessThan(OneTwoEight_multiply(spreadRem, count), OneTwoEight_multiply(meanRem, meanRem))) {
+        OneTwoEight_decrement(&spreadQuot);
+    }
+    return spreadQuot;
+}
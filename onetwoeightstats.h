@@ -0,0 +1,46 @@
+/*
+    Copyright (C) 2022 TheTrustedComputer
+*/
+
+#ifndef ONETWOEIGHTSTATS_H
+#define ONETWOEIGHTSTATS_H
+
+#include "onetwoeight.h"
+
+/*
+    Exact running statistics of 64-bit samples, accumulated in 128 bits by many threads at once.
+    Every writer thread owns a shard padded to a cache line, so recording is a handful of plain stores: no locks, no atomic read-modify-writes, no false sharing.
+    Readers merge the shards on demand, or a single publisher merges them at epoch boundaries so other readers only copy one cache line.
+*/
+typedef struct OneTwoEightStatsSummary {
+    OneTwoEight sum, sumSquares; // Wrap around past 128 bits like OneTwoEight_add
+    uint64_t count, min, max;
+} OneTwoEightStatsSummary;
+
+typedef struct OneTwoEightStatsShard {
+    _Alignas(64) atomic_uint sequence; // Odd while the owner is writing; readers retry until it stays even
+    OneTwoEightStatsSummary summary;
+} OneTwoEightStatsShard;
+
+typedef struct OneTwoEightStats {
+    OneTwoEightStatsShard published; // Shards merged at the last epoch boundary
+    atomic_uint shardsTaken;
+    unsigned shardCount;
+    OneTwoEightStatsShard shards[];
+} OneTwoEightStats;
+
+// Lifetime
+OneTwoEightStats *OneTwoEightStats_create(const unsigned); // Room for this many writer threads
+void OneTwoEightStats_destroy(OneTwoEightStats*);
+// Writers
+OneTwoEightStatsShard *OneTwoEightStats_acquireShard(OneTwoEightStats*); // Once per writer thread; NULL when every shard is taken
+void OneTwoEightStats_record(OneTwoEightStatsShard*, const uint64_t); // Only the thread that acquired the shard may record into it
+// Readers, safe alongside writers
+OneTwoEightStatsSummary OneTwoEightStats_merge(OneTwoEightStats*); // Reads every shard
+void OneTwoEightStats_publish(OneTwoEightStats*); // Epoch boundary; call from one thread at a time
+OneTwoEightStatsSummary OneTwoEightStats_published(OneTwoEightStats*); // Summary as of the last publish
+// Moments, exact for summaries whose sum of squares has not wrapped around
+OneTwoEight OneTwoEightStats_mean(const OneTwoEightStatsSummary, OneTwoEight*); // (sum / count), with the remainder
+OneTwoEight OneTwoEightStats_variance(const OneTwoEightStatsSummary); // Population variance, rounded down
+
+#endif // ONETWOEIGHTSTATS_H
@@ -0,0 +1,156 @@
+/*
+    Copyright (C) 2022 TheTrustedComputer
+*/
+
+#define _POSIX_C_SOURCE 199309L // clock_gettime and CLOCK_MONOTONIC under -std=c11
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include "onetwoeight.c"
+#include "onetwoeightroutes.c"
+
+// Prefix lengths of a typical IPv6 BGP table, in parts per thousand
+static const struct {
+    int length, share;
+} ROUTEBENCH_LENGTHS[] = {
+    {48, 450}, {32, 120}, {44, 80}, {40, 70}, {36, 50}, {29, 30}, {46, 25}, {33, 20}, {47, 15}, {34, 15}, {38, 15}, {42, 15}, {45, 15},
+    {35, 10}, {37, 10}, {39, 10}, {41, 10}, {43, 10}, {28, 10}, {30, 5}, {31, 5}, {24, 5}, {64, 5}
+};
+
+// Leading 16 bits of the address space the regional registries hand out from
+static const uint16_t ROUTEBENCH_REGISTRIES[] = {0x2001, 0x2400, 0x2401, 0x2402, 0x2403, 0x2404, 0x2405, 0x2406, 0x2407, 0x2408, 0x2600,
+    0x2602, 0x2603, 0x2604, 0x2605, 0x2606, 0x2607, 0x2610, 0x2620, 0x2800, 0x2801, 0x2803, 0x2a00, 0x2a01, 0x2a02, 0x2a03, 0x2a04, 0x2a05,
+    0x2a06, 0x2a07, 0x2a09, 0x2a0a, 0x2a0b, 0x2a0c, 0x2a0d, 0x2a0e, 0x2a0f, 0x2a10, 0x2c0f};
+
+static uint64_t routebenchState = 0x9e3779b97f4a7c15ull;
+
+static uint64_t routebench_random(void) {
+    // xorshift64, reproducible between runs unlike rand()
+    routebenchState ^= routebenchState << 13;
+    routebenchState ^= routebenchState >> 7;
+    routebenchState ^= routebenchState << 17;
+    return routebenchState;
+}
+
+static double routebench_seconds(void) {
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static int routebench_length(void) {
+    int pick = routebench_random() % 1000, length = 0;
+    
+    while (pick >= ROUTEBENCH_LENGTHS[length].share) {
+        pick -= ROUTEBENCH_LENGTHS[length++].share;
+    }
+    return ROUTEBENCH_LENGTHS[length].length;
+}
+
+// Driver code to measure longest prefix matching over a synthetic but realistically shaped IPv6 table
+int main(int argc, char **argv) {
+    size_t routeCount = (argc > 1) ? strtoull(argv[1], NULL, 10) : 200000, lookupCount = (argc > 2) ? strtoull(argv[2], NULL, 10) : 4194304;
+    size_t allocationCount = routeCount / 5 + 1, route, lookup, mismatches = 0;
+    OneTwoEight *allocations, *prefixes, *addresses, address;
+    int *lengths;
+    uint32_t *nextHops, checksum = 0;
+    OneTwoEightRoutes *routes;
+    double start, elapsed;
+    
+    // Lookups pick prefixes modulo their count, and an empty array would look like a failed allocation
+    if (!routeCount || !lookupCount) {
+        fprintf(stderr, "Usage: %s [prefixes] [lookups], both positive.\n", argv[0]);
+        return 1;
+    }
+    routes = OneTwoEightRoutes_create();
+    allocations = malloc(allocationCount * sizeof(OneTwoEight));
+    prefixes = malloc(routeCount * sizeof(OneTwoEight));
+    lengths = malloc(routeCount * sizeof(int));
+    addresses = malloc(lookupCount * sizeof(OneTwoEight));
+    nextHops = malloc(lookupCount * sizeof(uint32_t));
+    if (!allocations || !prefixes || !lengths || !addresses || !nextHops) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+    
+    // Registries hand out /32s, which their holders announce whole, aggregated, or split into longer prefixes clustered near the start
+    for (route = 0; route < allocationCount; ++route) {
+        allocations[route] = (OneTwoEight){0, ((OneTwoEight_t)(ROUTEBENCH_REGISTRIES[routebench_random() % (sizeof(ROUTEBENCH_REGISTRIES) / sizeof(ROUTEBENCH_REGISTRIES[0]))]) << 48) | ((routebench_random() & 0xffff) << 32)};
+    }
+    for (route = 0; route < routeCount; ++route) {
+        address = allocations[routebench_random() % allocationCount];
+        address.msb |= (routebench_random() & 0xf) << 28 | (routebench_random() & 0xfffffff);
+        address.lsb = routebench_random();
+        lengths[route] = routebench_length();
+        prefixes[route] = OneTwoEight_prefixNetwork(address, lengths[route]);
+    }
+    // Most traffic goes to announced space; the rest is spread over all of 2000::/3
+    for (lookup = 0; lookup < lookupCount; ++lookup) {
+        address = (OneTwoEight){routebench_random(), routebench_random()};
+        if (routebench_random() % 10) {
+            route = routebench_random() % routeCount;
+            addresses[lookup] = OneTwoEight_bitwiseOr(prefixes[route], OneTwoEight_bitwiseAnd(address, OneTwoEight_bitwiseNot(OneTwoEight_prefixMask(lengths[route]))));
+        }
+        else {
+            addresses[lookup] = (OneTwoEight){address.lsb, (address.msb & 0x1fffffffffffffffull) | 0x2000000000000000ull};
+        }
+    }
+    
+    start = routebench_seconds();
+    for (route = 0; route < routeCount; ++route) {
+        OneTwoEightRoutes_insert(routes, prefixes[route], lengths[route], (uint32_t)(route % 1024));
+    }
+    elapsed = routebench_seconds() - start;
+    printf("Inserted %zu prefixes (%zu distinct) in %.3f s: %.0f inserts/s\n", routeCount, routes->ruleCount, elapsed, routeCount / elapsed);
+    printf("Groups: %" PRIu32 ", table memory: %.1f MiB\n", routes->groupsInUse,
+        (sizeof(routes->top) + (double)(routes->groupCapacity) * sizeof(routes->groups[0]) + routes->ruleCapacity * sizeof(OneTwoEightRoutesRule)) / 1048576);
+    
+    start = routebench_seconds();
+    for (lookup = 0; lookup < lookupCount; ++lookup) {
+        checksum += OneTwoEightRoutes_lookup(routes, addresses[lookup]);
+    }
+    elapsed = routebench_seconds() - start;
+    printf("Single lookups: %.2f M lookups/s (checksum %" PRIu32 ")\n", lookupCount / elapsed / 1e6, checksum);
+    
+    start = routebench_seconds();
+    OneTwoEightRoutes_lookupBatch(routes, addresses, nextHops, lookupCount);
+    elapsed = routebench_seconds() - start;
+    printf("Batched lookups: %.2f M lookups/s\n", lookupCount / elapsed / 1e6);
+    for (lookup = 0; lookup < lookupCount; ++lookup) {
+        mismatches += (nextHops[lookup] != OneTwoEightRoutes_lookup(routes, addresses[lookup]));
+    }
+    
+    // Route churn: withdraw and re-announce a tenth of the table
+    start = routebench_seconds();
+    for (route = 0; route < routeCount / 10; ++route) {
+        OneTwoEightRoutes_remove(routes, prefixes[route], lengths[route]);
+    }
+    for (route = 0; route < routeCount / 10; ++route) {
+        OneTwoEightRoutes_insert(routes, prefixes[route], lengths[route], (uint32_t)(route % 1024));
+    }
+    elapsed = routebench_seconds() - start;
+    printf("Churned %zu prefixes in %.3f s: %.0f updates/s\n", routeCount / 10, elapsed, 2 * (routeCount / 10) / elapsed);
+    
+    OneTwoEightRoutes_destroy(routes);
+    free(allocations);
+    free(prefixes);
+    free(lengths);
+    free(addresses);
+    free(nextHops);
+    
+    // Batched and single lookups must agree
+    if (mismatches) {
+        printf("Error: %zu batched lookups differ!\n", mismatches);
+        return 1;
+    }
+    return 0;
+}